@@ -0,0 +1,236 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "preflow_statistics.h"
+#include "node_state.h"
+#include "cache_aligned.h"
+namespace lemon {
+    // elevator of the asynchronous solver: atomic labels, an active flag per
+    // node and one queue of active nodes per thread. A thread takes its newest
+    // node first and steals the oldest node of another thread when it runs dry.
+    template<class GR, class Item, class State = PackedNodeState<int, std::atomic<int> > >
+    class AsyncElevator {
+    public:
+        typedef typename GR::NodeIt NodeIt;
+        typedef State NodeState;
+    private:
+        // ring buffer of node ids, the active flags queue a node at most
+        // once, so a capacity of the node count never overflows and the
+        // discharge loop does not allocate
+        struct Queue {
+            std::unique_ptr<int[]> items;
+            int capacity = 0;
+            int head = 0;
+            int count = 0;
+            std::atomic_flag lock = ATOMIC_FLAG_INIT;
+            void acquire() {
+                while (lock.test_and_set(std::memory_order_acquire))
+                    std::this_thread::yield();
+            }
+            void release() {
+                lock.clear(std::memory_order_release);
+            }
+            void reserve(int n) {
+                if (n > capacity) {
+                    items.reset(new int[n]);
+                    capacity = n;
+                }
+                head = 0;
+                count = 0;
+            }
+            void pushBack(int id) {
+                int pos = head + count;
+                items[pos < capacity ? pos : pos - capacity] = id;
+                count++;
+            }
+            int popBack() {
+                count--;
+                int pos = head + count;
+                return items[pos < capacity ? pos : pos - capacity];
+            }
+            int popFront() {
+                int id = items[head];
+                if (++head == capacity)
+                    head = 0;
+                count--;
+                return id;
+            }
+        };
+
+        const GR* _graph;
+        int _max_level;
+        int _item_num;
+        // labels, excess and current arcs, with atomic labels
+        State _state;
+        std::unique_ptr<std::atomic<bool>[]> _active;
+        int _active_capacity;
+        // a cache line of its own for every queue
+        CacheAlignedArray<Queue> _queues;
+        int _thread_cnt;
+        // number of nodes which are queued or being discharged
+        std::atomic<int> _pending;
+        int _init_level = 0;
+
+    public:
+        AsyncElevator(const GR& graph, int max_level, int thread_count = 1)
+            : _active_capacity(0), _queues(thread_count),
+            _thread_cnt(thread_count), _pending(0) {
+            reset(graph, max_level);
+        }
+        AsyncElevator(const AsyncElevator& ele)
+            : _graph(ele._graph), _max_level(ele._max_level), _item_num(ele._item_num),
+            _state(ele._state), _active(new std::atomic<bool>[ele._item_num]),
+            _active_capacity(ele._item_num), _queues(ele._thread_cnt), _thread_cnt(ele._thread_cnt),
+            _pending(ele._pending.load()), _init_level(ele._init_level) {
+            for (int i = 0; i < _item_num; i++)
+                _active[i].store(ele._active[i].load());
+            for (int t = 0; t < _thread_cnt; t++) {
+                const Queue& q = ele._queues[t];
+                _queues[t].reserve(_item_num);
+                for (int k = 0; k < q.count; k++) {
+                    int pos = q.head + k;
+                    _queues[t].pushBack(q.items[pos < q.capacity ? pos : pos - q.capacity]);
+                }
+            }
+        }
+
+        // rebind to a graph, the arrays keep their memory if it suffices
+        void reset(const GR& graph, int max_level) {
+            _graph = &graph;
+            _max_level = max_level;
+            _item_num = graph.maxNodeId() + 1;
+            _state.resize(_item_num);
+            if (_item_num > _active_capacity) {
+                _active.reset(new std::atomic<bool>[_item_num]);
+                _active_capacity = _item_num;
+            }
+            for (int i = 0; i < _item_num; i++)
+                _active[i].store(false, std::memory_order_relaxed);
+            for (int t = 0; t < _thread_cnt; t++)
+                _queues[t].reserve(_item_num);
+            _pending.store(0);
+        }
+
+        int threadCount() const {
+            return _thread_cnt;
+        }
+        int pending() const {
+            return _pending.load();
+        }
+
+        // queue the item unless it is active already
+        void activate(Item i, int thread_id = 0) {
+            int id = _graph->id(i);
+            if (_active[id].exchange(true))
+                return;
+            _pending.fetch_add(1);
+            Queue& q = _queues[thread_id];
+            q.acquire();
+            q.pushBack(id);
+            q.release();
+        }
+        // called by the thread which discharged the item, the caller has to
+        // activate it again if it got excess meanwhile, and then call done()
+        void deactivate(Item i) {
+            _active[_graph->id(i)].store(false);
+        }
+        void done() {
+            _pending.fetch_sub(1);
+        }
+        bool active(Item i) const {
+            return _active[_graph->id(i)].load();
+        }
+
+        // take an active item of the given thread, or steal one
+        bool pop(Item& item, int thread_id) {
+            Queue& own = _queues[thread_id];
+            own.acquire();
+            if (own.count > 0) {
+                item = _graph->nodeFromId(own.popBack());
+                own.release();
+                return true;
+            }
+            own.release();
+            for (int k = 1; k < _thread_cnt; k++) {
+                Queue& victim = _queues[(thread_id + k) % _thread_cnt];
+                victim.acquire();
+                if (victim.count > 0) {
+                    item = _graph->nodeFromId(victim.popFront());
+                    victim.release();
+                    return true;
+                }
+                victim.release();
+            }
+            return false;
+        }
+
+        int operator[](Item i) const {
+            return _state.level(_graph->id(i)).load(std::memory_order_relaxed);
+        }
+        void lift(Item i, int new_level) {
+            _state.level(_graph->id(i)).store(new_level, std::memory_order_relaxed);
+        }
+        int maxLevel() const {
+            return _max_level;
+        }
+        // label, excess and current arc of the items, shared with the solver
+        State& nodeState() {
+            return _state;
+        }
+
+        void initStart() {
+            for (NodeIt n(*_graph); n != INVALID; ++n)
+                _state.level(_graph->id(n)).store(-1, std::memory_order_relaxed);
+            for (int i = 0; i < _item_num; i++)
+                _active[i].store(false, std::memory_order_relaxed);
+            for (int t = 0; t < _thread_cnt; t++) {
+                _queues[t].head = 0;
+                _queues[t].count = 0;
+            }
+            _pending.store(0);
+            _init_level = 0;
+        }
+        void initAddItem(Item i) {
+            _state.level(_graph->id(i)).store(_init_level, std::memory_order_relaxed);
+        }
+        void initNewLevel() {
+            ++_init_level;
+        }
+        void initFinish() {
+            for (NodeIt n(*_graph); n != INVALID; ++n) {
+                if ((*this)[n] == -1)
+                    lift(n, _max_level);
+            }
+        }
+    };
+    template <typename GR, typename CAP,
+              typename NS = PackedNodeState<typename CAP::Value, std::atomic<int> > >
+    struct Preflow_AsyncDefaultTraits {
+        typedef GR Digraph;
+        typedef CAP CapacityMap;
+        typedef typename CapacityMap::Value Value;
+        typedef typename Digraph::template ArcMap<Value> FlowMap;
+        static FlowMap* createFlowMap(const Digraph& digraph) {
+            return new FlowMap(digraph);
+        }
+        // the threads read the labels of their neighbours, NS needs
+        // std::atomic<int> labels
+        typedef NS NodeState;
+        typedef AsyncElevator<Digraph, typename Digraph::Node, NodeState> Elevator;
+        static Elevator* createElevator(const Digraph& digraph, int max_level) {
+#if OPENMP
+            int thread_cnt = omp_get_max_threads();
+#else
+            int thread_cnt = 1;
+#endif
+            return new Elevator(digraph, max_level, thread_cnt);
+        }
+        typedef lemon::Tolerance<Value> Tolerance;
+        typedef NoPreflowStatistics Statistics;
+    };
+}
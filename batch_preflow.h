@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <lemon/core.h>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "mf_base.h"
+
+namespace lemon {
+    // maximum flows of many (source, target) pairs on one digraph. The
+    // residual arc structure is built once and shared, every thread keeps its
+    // own solver between the queries and between the calls of run(), so a
+    // query only resets capacities and labels. The pairs are spread over the
+    // threads dynamically.
+    template <typename GR,
+        typename CAP = typename GR::template ArcMap<int>,
+        typename PF = Preflow_HL<GR, CAP> >
+    class BatchPreflow {
+    public:
+        typedef GR Digraph;
+        typedef CAP CapacityMap;
+        typedef typename CapacityMap::Value Value;
+        typedef PF Preflow;
+        typedef typename Digraph::Node Node;
+        typedef std::pair<Node, Node> Query;
+        typedef lemon::ResidualGraph<Digraph, Value> ResidualGraph;
+    private:
+        typedef typename Digraph::NodeIt NodeIt;
+
+        const Digraph& _graph;
+        const CapacityMap& _capacity;
+        ResidualGraph _res;
+        std::vector<std::unique_ptr<Preflow> > _solvers;
+        std::vector<Value> _flow_values;
+        // node ids on the source side, one block of maxNodeId() + 1 per query
+        std::vector<char> _cuts;
+        int _node_num;
+
+        static int threadNum() {
+#if OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+        static int threadId() {
+#if OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+    public:
+        BatchPreflow(const Digraph& digraph, const CapacityMap& capacity)
+            : _graph(digraph), _capacity(capacity),
+            _node_num(digraph.maxNodeId() + 1) {
+            _res.build(digraph);
+        }
+
+        // solve all queries, with_cut keeps the minimum cut of each query,
+        // see minCut()
+        void run(const std::vector<Query>& queries, bool with_cut = false) {
+            int query_num = int(queries.size());
+            _flow_values.resize(query_num);
+            if (with_cut)
+                _cuts.resize((size_t)query_num * _node_num);
+            int thread_num = threadNum();
+            if (int(_solvers.size()) < thread_num)
+                _solvers.resize(thread_num);
+            for (int t = 0; t < thread_num; t++) {
+                if (!_solvers[t]) {
+                    _solvers[t].reset(new Preflow(_graph, _capacity, INVALID, INVALID));
+                    _solvers[t]->shareResidualGraph(_res);
+                }
+            }
+            #pragma omp parallel for schedule(dynamic)
+            for (int q = 0; q < query_num; q++) {
+                Preflow& pf = *_solvers[threadId()];
+                pf.source(queries[q].first).target(queries[q].second);
+                pf.init();
+                pf.startFirstPhase();
+                if (with_cut) {
+                    pf.startSecondPhase();
+                    char* cut = &_cuts[(size_t)q * _node_num];
+                    for (NodeIt n(_graph); n != INVALID; ++n)
+                        cut[_graph.id(n)] = pf.minCut(n);
+                }
+                _flow_values[q] = pf.flowValue();
+            }
+        }
+
+        Value flowValue(int query) const {
+            return _flow_values[query];
+        }
+        // the node is on the source side of the minimum cut of the query,
+        // requires run() with with_cut
+        bool minCut(int query, const Node& node) const {
+            return _cuts[(size_t)query * _node_num + _graph.id(node)] != 0;
+        }
+    };
+}
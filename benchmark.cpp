@@ -0,0 +1,212 @@
+/**
+ * runs the maximum flow implementations on the generated benchmark families
+ * over a sweep of sizes and prints one record per (family, size, method)
+ */
+#include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/program_options.hpp>
+#include <lemon/list_graph.h>
+#include <lemon/preflow.h>
+#include "mf_base.h"
+#include "graph_generators.h"
+
+using namespace lemon;
+
+struct Record {
+    std::string family;
+    int size;
+    int nodes;
+    int arcs;
+    std::string method;
+    double seconds;
+    double flow;
+    bool agree;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// build an instance of the family with about size nodes, rbf with about
+// as many arcs as the sparse families
+template <typename Digraph, typename ArcMap>
+void generate(const std::string& family, int size, unsigned seed,
+    Digraph& g, ArcMap& cap, typename Digraph::Node& s, typename Digraph::Node& t) {
+    if (family == "genrmf") {
+        int a = std::max(2, int(std::cbrt(size / 2.0)));
+        int b = std::max(2, size / (a * a));
+        genrmf(g, cap, s, t, a, b, 1, 100, seed);
+    } else if (family == "washington") {
+        int rows = std::max(2, int(std::sqrt(double(size))));
+        washingtonRLG(g, cap, s, t, rows, std::max(2, size / rows), 10000, seed);
+    } else if (family == "ak") {
+        akNetwork(g, cap, s, t, std::max(1, (size - 6) / 4));
+    } else if (family == "grid4" || family == "grid8") {
+        int w = std::max(2, int(std::sqrt(double(size))));
+        visionGrid(g, cap, s, t, w, w, family == "grid8" ? 8 : 4, 100, seed);
+    } else if (family == "rbf") {
+        // dense, about 4 * size arcs like the sparse families
+        rbfGraph(g, cap, s, t, std::max(2, int(std::sqrt(8.0 * size))), 0.6, seed);
+    } else {
+        throw std::invalid_argument("unknown family " + family);
+    }
+}
+
+template <typename Alg>
+double timeRun(Alg& alg, double& flow) {
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    alg.run();
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+    flow = alg.flowValue();
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+// solve with one method, the best of repeat runs
+template <typename Digraph, typename ArcMap>
+double solve(const Digraph& g, const ArcMap& cap, typename Digraph::Node s, typename Digraph::Node t,
+    const std::string& method, double global_relabel_freq, int repeat, double& flow) {
+    double best = -1;
+    for (int r = 0; r < repeat; r++) {
+        double seconds;
+        if (method == "rtf") {
+            Preflow_Relabel<Digraph, ArcMap> alg(g, cap, s, t);
+            alg.globalRelabelFrequency(global_relabel_freq);
+            seconds = timeRun(alg, flow);
+        } else if (method == "fifo") {
+            Preflow_FIFO<Digraph, ArcMap> alg(g, cap, s, t);
+            alg.globalRelabelFrequency(global_relabel_freq);
+            seconds = timeRun(alg, flow);
+        } else if (method == "hl") {
+            Preflow_HL<Digraph, ArcMap> alg(g, cap, s, t);
+            alg.globalRelabelFrequency(global_relabel_freq);
+            seconds = timeRun(alg, flow);
+        } else if (method == "pg") {
+            Preflow_Parallel<Digraph, ArcMap> alg(g, cap, s, t);
+            seconds = timeRun(alg, flow);
+        } else if (method == "async") {
+            Preflow_Async<Digraph, ArcMap> alg(g, cap, s, t);
+            seconds = timeRun(alg, flow);
+        } else if (method == "o_hl") {
+            Preflow<Digraph, ArcMap> alg(g, cap, s, t);
+            seconds = timeRun(alg, flow);
+        } else {
+            throw std::invalid_argument("unknown method " + method);
+        }
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+template <typename Value>
+void benchmark(const std::string& family, int size, unsigned seed,
+    const std::vector<std::string>& methods, double global_relabel_freq, int repeat,
+    std::vector<Record>& records) {
+    typedef ListDigraph Digraph;
+    typedef Digraph::ArcMap<Value> ArcMap;
+    Digraph g;
+    ArcMap cap(g);
+    Digraph::Node s, t;
+    generate(family, size, seed, g, cap, s, t);
+    // LEMON's Preflow is the reference value
+    double reference;
+    Preflow<Digraph, ArcMap> ref(g, cap, s, t);
+    ref.run();
+    reference = ref.flowValue();
+    for (const std::string& method : methods) {
+        Record r;
+        r.family = family;
+        r.size = size;
+        r.nodes = countNodes(g);
+        r.arcs = countArcs(g);
+        r.method = method;
+        r.seconds = solve(g, cap, s, t, method, global_relabel_freq, repeat, r.flow);
+        r.agree = std::abs(r.flow - reference) <= 1e-6 * (1 + std::abs(reference));
+        records.push_back(r);
+    }
+}
+
+void print(const std::vector<Record>& records, const std::string& format) {
+    if (format == "json") {
+        std::cout << "[\n";
+        for (size_t i = 0; i < records.size(); i++) {
+            const Record& r = records[i];
+            std::cout << "  {\"family\": \"" << r.family << "\", \"size\": " << r.size
+                << ", \"nodes\": " << r.nodes << ", \"arcs\": " << r.arcs
+                << ", \"method\": \"" << r.method << "\", \"seconds\": " << r.seconds
+                << ", \"flow\": " << r.flow << ", \"agree\": " << (r.agree ? "true" : "false") << '}'
+                << (i + 1 < records.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+        return;
+    }
+    std::cout << "family,size,nodes,arcs,method,seconds,flow,agree\n";
+    for (const Record& r : records) {
+        std::cout << r.family << ',' << r.size << ',' << r.nodes << ',' << r.arcs << ','
+            << r.method << ',' << r.seconds << ',' << r.flow << ',' << r.agree << '\n';
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    boost::program_options::options_description desc;
+    desc.add_options()
+        ("help,h", "Show this help screen")
+        ("family", boost::program_options::value<std::string>()->default_value("genrmf,washington,ak,grid4,grid8,rbf"),
+            "comma separated graph families: genrmf, washington, ak, grid4, grid8, rbf")
+        ("sizes", boost::program_options::value<std::string>()->default_value("1000,4000,16000"),
+            "comma separated approximate node numbers")
+        ("method", boost::program_options::value<std::string>()->default_value("rtf,fifo,hl,pg,o_hl"),
+            "comma separated maxflow implementations: rtf, fifo, hl, pg, async, o_hl")
+        ("format", boost::program_options::value<std::string>()->default_value("csv"), "output format: csv or json")
+        ("repeat", boost::program_options::value<int>()->default_value(1), "runs per method, the fastest is reported")
+        ("seed", boost::program_options::value<unsigned>()->default_value(1), "random seed of the generators")
+        ("global_relabel", boost::program_options::value<double>()->default_value(0.5),
+            "frequency of the global relabel heuristic for rtf, hl and fifo, 0 disables it");
+    boost::program_options::variables_map vm;
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+    boost::program_options::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << '\n';
+        return 0;
+    }
+    std::vector<std::string> families = split(vm["family"].as<std::string>());
+    std::vector<std::string> methods = split(vm["method"].as<std::string>());
+    std::vector<std::string> sizes = split(vm["sizes"].as<std::string>());
+    int repeat = std::max(1, vm["repeat"].as<int>());
+    unsigned seed = vm["seed"].as<unsigned>();
+    double global_relabel_freq = vm["global_relabel"].as<double>();
+    std::vector<Record> records;
+    try {
+        for (const std::string& family : families) {
+            for (const std::string& size : sizes) {
+                // rbf has real valued capacities, the DIMACS families integral ones
+                if (family == "rbf")
+                    benchmark<double>(family, std::stoi(size), seed, methods, global_relabel_freq, repeat, records);
+                else
+                    benchmark<int>(family, std::stoi(size), seed, methods, global_relabel_freq, repeat, records);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    print(records, vm["format"].as<std::string>());
+    bool agree = true;
+    for (const Record& r : records)
+        agree = agree && r.agree;
+    return agree ? 0 : 2;
+}
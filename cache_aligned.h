@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+namespace lemon {
+    // array of per thread slots, each starting on a cache line of its own
+    // and padded to whole lines, so threads do not share lines. new[] and
+    // std::allocator do not honour alignas(64) before C++17, the storage is
+    // aligned by hand. assign() keeps the memory if the size does not grow.
+    template <typename T>
+    class CacheAlignedArray {
+        static const std::size_t LINE = 64;
+        static const std::size_t STRIDE = (sizeof(T) + LINE - 1) / LINE * LINE;
+        std::unique_ptr<char[]> _raw;
+        char* _base;
+        int _size;
+        int _capacity;
+
+        void destroy() {
+            for (int i = 0; i < _size; i++)
+                (*this)[i].~T();
+            _size = 0;
+        }
+    public:
+        CacheAlignedArray() : _base(NULL), _size(0), _capacity(0) {}
+        explicit CacheAlignedArray(int n) : _base(NULL), _size(0), _capacity(0) {
+            assign(n);
+        }
+        CacheAlignedArray(const CacheAlignedArray& a) : _base(NULL), _size(0), _capacity(0) {
+            assign(a._size);
+            for (int i = 0; i < _size; i++)
+                (*this)[i] = a[i];
+        }
+        CacheAlignedArray& operator=(const CacheAlignedArray& a) {
+            if (this != &a) {
+                assign(a._size);
+                for (int i = 0; i < _size; i++)
+                    (*this)[i] = a[i];
+            }
+            return *this;
+        }
+        ~CacheAlignedArray() {
+            destroy();
+        }
+
+        // n default constructed slots
+        void assign(int n) {
+            destroy();
+            if (n > _capacity) {
+                _raw.reset(new char[n * STRIDE + LINE - 1]);
+                std::uintptr_t p = reinterpret_cast<std::uintptr_t>(_raw.get());
+                _base = _raw.get() + (LINE - p % LINE) % LINE;
+                _capacity = n;
+            }
+            for (; _size < n; _size++)
+                new (_base + _size * STRIDE) T();
+        }
+        int size() const { return _size; }
+        T& operator[](int i) { return *reinterpret_cast<T*>(_base + i * STRIDE); }
+        const T& operator[](int i) const { return *reinterpret_cast<const T*>(_base + i * STRIDE); }
+    };
+}
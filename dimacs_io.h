@@ -0,0 +1,225 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <cstdlib>
+#include <type_traits>
+#include <limits>
+#include <lemon/core.h>
+#include <lemon/error.h>
+
+namespace lemon {
+    namespace _dimacs_bits {
+        // buffered character scanner over a stream buffer, numbers are parsed
+        // in place so that no string is built per line
+        class Scanner {
+            std::streambuf* _buf;
+            char _data[1 << 16];
+            char* _pos;
+            char* _end;
+            int _line;
+
+            bool fill() {
+                std::streamsize n = _buf->sgetn(_data, sizeof(_data));
+                _pos = _data;
+                _end = _data + (n > 0 ? n : 0);
+                return _pos != _end;
+            }
+        public:
+            explicit Scanner(std::istream& is)
+                : _buf(is.rdbuf()), _pos(_data), _end(_data), _line(1) {}
+
+            int line() const { return _line; }
+            // next character without consuming it, EOF at the end of the input
+            int peek() {
+                if (_pos == _end && !fill())
+                    return EOF;
+                return (unsigned char)*_pos;
+            }
+            int get() {
+                int c = peek();
+                if (c != EOF) {
+                    ++_pos;
+                    if (c == '\n')
+                        ++_line;
+                }
+                return c;
+            }
+            // skip spaces and tabs, but not the end of line
+            void skipBlanks() {
+                int c;
+                while ((c = peek()) == ' ' || c == '\t' || c == '\r')
+                    ++_pos;
+            }
+            void skipLine() {
+                int c;
+                while ((c = get()) != EOF && c != '\n') {}
+            }
+            // consume the rest of the line, which must be blank
+            void endLine() {
+                skipBlanks();
+                int c = get();
+                if (c != EOF && c != '\n')
+                    throw FormatError("Unexpected characters at the end of line", "", _line);
+            }
+            void expect(const char* word) {
+                skipBlanks();
+                for (; *word; ++word) {
+                    if (get() != *word)
+                        throw FormatError("Invalid problem line, expected 'p max'", "", _line);
+                }
+            }
+            long long readInt() {
+                skipBlanks();
+                bool neg = false;
+                if (peek() == '-' || peek() == '+')
+                    neg = get() == '-';
+                if (peek() < '0' || peek() > '9')
+                    throw FormatError("Integer expected", "", _line);
+                // the magnitude is summed unsigned, -2^63 is in range as well
+                unsigned long long limit = (unsigned long long)std::numeric_limits<long long>::max() + (neg ? 1 : 0);
+                unsigned long long value = 0;
+                while (peek() >= '0' && peek() <= '9') {
+                    unsigned digit = unsigned(get() - '0');
+                    if (value > (limit - digit) / 10)
+                        throw FormatError("Integer out of range", "", _line);
+                    value = value * 10 + digit;
+                }
+                return neg ? (long long)(0 - value) : (long long)value;
+            }
+            template <typename V>
+            typename std::enable_if<std::is_integral<V>::value, V>::type readValue() {
+                typedef std::numeric_limits<V> Limits;
+                long long value = readInt();
+                bool below = Limits::is_signed ? value < (long long)Limits::min() : value < 0;
+                // V wider than long long holds every value read
+                bool above = std::numeric_limits<long long>::digits > Limits::digits &&
+                    value > (long long)Limits::max();
+                if (below || above)
+                    throw FormatError("Capacity out of range of the value type", "", _line);
+                return V(value);
+            }
+            template <typename V>
+            typename std::enable_if<!std::is_integral<V>::value, V>::type readValue() {
+                skipBlanks();
+                char token[64];
+                int len = 0;
+                int c;
+                while ((c = peek()) != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                    if (len + 1 == int(sizeof(token)))
+                        throw FormatError("Number too long", "", _line);
+                    token[len++] = char(get());
+                }
+                token[len] = '\0';
+                char* stop;
+                double value = std::strtod(token, &stop);
+                if (len == 0 || *stop != '\0')
+                    throw FormatError("Number expected", "", _line);
+                return V(value);
+            }
+        };
+    }
+
+    // read a maximum flow problem in DIMACS format ("p max", "n" and "a" lines,
+    // "c" lines are comments) into an empty digraph in a single pass.
+    // The i-th DIMACS node becomes the i-th node added to the digraph.
+    template <typename Digraph, typename CapacityMap>
+    void readDimacsMaxFlow(std::istream& is, Digraph& digraph, CapacityMap& capacity,
+        typename Digraph::Node& source, typename Digraph::Node& target) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        _dimacs_bits::Scanner sc(is);
+        std::vector<Node> nodes;
+        long long arc_num = -1;
+        long long arc_read = 0;
+        source = target = INVALID;
+        int c;
+        while ((c = sc.peek()) != EOF) {
+            sc.get();
+            switch (c) {
+            case 'c':
+                sc.skipLine();
+                break;
+            case '\n':
+            case '\r':
+            case ' ':
+            case '\t':
+                break;
+            case 'p': {
+                if (arc_num >= 0)
+                    throw FormatError("Multiple problem lines", "", sc.line());
+                sc.expect("max");
+                long long n = sc.readInt();
+                arc_num = sc.readInt();
+                if (n < 0 || arc_num < 0)
+                    throw FormatError("Negative problem size", "", sc.line());
+                sc.endLine();
+                nodes.resize(n);
+                for (long long i = 0; i < n; i++)
+                    nodes[i] = digraph.addNode();
+                break;
+            }
+            case 'n': {
+                if (arc_num < 0)
+                    throw FormatError("Node line before the problem line", "", sc.line());
+                long long id = sc.readInt();
+                if (id < 1 || id > (long long)nodes.size())
+                    throw FormatError("Node id out of range", "", sc.line());
+                sc.skipBlanks();
+                int kind = sc.get();
+                if (kind == 's')
+                    source = nodes[id - 1];
+                else if (kind == 't')
+                    target = nodes[id - 1];
+                else
+                    throw FormatError("Node designator must be 's' or 't'", "", sc.line());
+                sc.endLine();
+                break;
+            }
+            case 'a': {
+                if (arc_num < 0)
+                    throw FormatError("Arc line before the problem line", "", sc.line());
+                long long u = sc.readInt();
+                long long v = sc.readInt();
+                if (u < 1 || u > (long long)nodes.size() || v < 1 || v > (long long)nodes.size())
+                    throw FormatError("Node id out of range", "", sc.line());
+                Value cap = sc.template readValue<Value>();
+                sc.endLine();
+                capacity.set(digraph.addArc(nodes[u - 1], nodes[v - 1]), cap);
+                arc_read++;
+                break;
+            }
+            default:
+                throw FormatError("Unknown line type", "", sc.line());
+            }
+        }
+        if (arc_num < 0)
+            throw FormatError("Missing problem line", "", sc.line());
+        if (arc_read != arc_num)
+            throw FormatError("Arc count differs from the problem line", "", sc.line());
+        if (source == INVALID || target == INVALID)
+            throw FormatError("Missing source or target node", "", sc.line());
+    }
+
+    // write a maximum flow problem in DIMACS format, nodes are numbered
+    // from 1 in NodeIt order
+    template <typename Digraph, typename CapacityMap>
+    void writeDimacsMaxFlow(std::ostream& os, const Digraph& digraph, const CapacityMap& capacity,
+        typename Digraph::Node source, typename Digraph::Node target) {
+        typedef typename Digraph::NodeIt NodeIt;
+        typedef typename Digraph::ArcIt ArcIt;
+        typename Digraph::template NodeMap<int> index(digraph);
+        int n = 0;
+        for (NodeIt v(digraph); v != INVALID; ++v)
+            index[v] = ++n;
+        std::streamsize precision = os.precision(
+            std::numeric_limits<typename CapacityMap::Value>::max_digits10);
+        os << "p max " << n << ' ' << countArcs(digraph) << '\n';
+        os << "n " << index[source] << " s\n";
+        os << "n " << index[target] << " t\n";
+        for (ArcIt e(digraph); e != INVALID; ++e)
+            os << "a " << index[digraph.source(e)] << ' ' << index[digraph.target(e)]
+               << ' ' << capacity[e] << '\n';
+        os.precision(precision);
+    }
+}
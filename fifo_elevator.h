@@ -1,108 +1,174 @@
-#include <list>
+#include <vector>
+#include <algorithm>
+#include "node_state.h"
 namespace lemon{
-    template<class GR, class Item>
+    template<class GR, class Item, class State = PackedNodeState<int> >
     class FIFOElevator{
         //relabel to front elevator
         
     public:
         typedef int Value;
-        typedef typename std::list<Item>::iterator iterator; 
 		typedef typename GR::NodeIt NodeIt;
+        typedef State NodeState;
     private:
         typedef typename ItemSetTraits<GR, Item>::
         template Map<int>::Type IntMap;
         typedef typename ItemSetTraits<GR, Item>::
         template Map<bool>::Type BoolMap;
         
-        const GR &_graph;
+        const GR* _graph;
         int _max_level;
-		iterator first_phase_item_pointer;
-        IntMap _level;
-        std::list<Item> fifo_list;
+        State _state;
+        // circular queue of item ids, an item is queued at most once so
+        // its capacity is the number of items
+        std::vector<int> _queue;
+        int _head = 0;
+        int _size = 0;
+        // items met at _max_level or above in the first phase, they are
+        // only handed out in the second phase
+        std::vector<int> _parked;
+        std::vector<char> _active;
+        // the item is in _queue or in _parked, it is skipped there once
+        // it has been deactivated
+        std::vector<char> _queued;
+
+        void push(int id) {
+            int tail = _head + _size;
+            if (tail >= int(_queue.size()))
+                tail -= int(_queue.size());
+            _queue[tail] = id;
+            _size++;
+        }
+        int pop() {
+            int id = _queue[_head];
+            if (++_head == int(_queue.size()))
+                _head = 0;
+            _size--;
+            return id;
+        }
 
     public:
-		FIFOElevator(const GR& graph, int max_level)
-        : _graph(graph), _max_level(max_level),
-          _level(graph), _init_level(0){
-			first_phase_item_pointer = fifo_list.begin();
-		}
-        
-		FIFOElevator(const FIFOElevator& ele):
-			_graph(ele._graph), _max_level(ele._max_level),fifo_list(ele.fifo_list),
-			_level(ele._graph){
-			for (NodeIt n(_graph); n != INVALID; ++n) {
-				_level[n] = ele._level[n];
-			}			
+		FIFOElevator(const GR& graph, int max_level) : _init_level(0){
+			reset(graph, max_level);
 		}
 
+		FIFOElevator(const FIFOElevator& ele) = default;
+
+        // rebind to a graph, the arrays keep their memory if it suffices
+        void reset(const GR& graph, int max_level) {
+            int item_num = graph.maxNodeId() + 1;
+            _graph = &graph;
+            _max_level = max_level;
+            _state.resize(item_num);
+            _queue.resize(item_num);
+            _head = _size = 0;
+            _parked.clear();
+            _active.assign(item_num, 0);
+            _queued.assign(item_num, 0);
+        }
+
         void activate(Item i) {
-            fifo_list.push_back(i);
+            int id = _graph->id(i);
+            _active[id] = 1;
+            if (!_queued[id]) {
+                _queued[id] = 1;
+                push(id);
+            }
         }
         
-        inline void deactivate(Item i) {
+        void deactivate(Item i) {
+            _active[_graph->id(i)] = 0;
         }
         
-        inline bool active(Item i) const { return false; }
+        bool active(Item i) const { return _active[_graph->id(i)] != 0; }
         
-        int operator[](Item i) const { return _level[i]; }
+        int operator[](Item i) const { return _state.level(_graph->id(i)); }
 
         void lift(Item i, int new_level) {
-            _level[i] = new_level;
+            _state.level(_graph->id(i)) = new_level;
         }
 
         int maxLevel() const {
             return _max_level;
         }
+        // label, excess and current arc of the items, shared with the solver
+        State& nodeState() {
+            return _state;
+        }
 
-         bool getFront(Item& item, bool limit_max_level = false) {
-			 if (fifo_list.size() == 0)
-				 return false;
-			if (limit_max_level) {
-				if (is_initialized == false) {
-					first_phase_item_pointer = fifo_list.begin();
-					is_initialized = true;
-				}
-				while (first_phase_item_pointer != fifo_list.end()) {
-					item = *first_phase_item_pointer;
-					if (_level[item] < _max_level) {						
-						first_phase_item_pointer = fifo_list.erase(first_phase_item_pointer);
-						if (first_phase_item_pointer == fifo_list.end())
-							is_initialized = false;
-						return true;
-					}
-					first_phase_item_pointer++;					
-				}
-				return false;
-			}
-			else {
-				item = fifo_list.front();
-				fifo_list.pop_front();
-				return true;
-			}
-		}
+        // take the oldest active item, with limit_max_level items at
+        // _max_level or above are parked for the second phase instead.
+        // The item is no longer active afterwards.
+        bool getFront(Item& item, bool limit_max_level = false) {
+            while (_size > 0) {
+                int id = pop();
+                if (!_active[id]) {
+                    _queued[id] = 0;
+                    continue;
+                }
+                if (limit_max_level && _state.level(id) >= _max_level) {
+                    _parked.push_back(id);
+                    continue;
+                }
+                _queued[id] = 0;
+                _active[id] = 0;
+                item = _graph->nodeFromId(id);
+                return true;
+            }
+            if (limit_max_level) {
+                // parked items lowered meanwhile (warm start) return to the
+                // queue, deactivated ones are dropped
+                int kept = 0;
+                for (int id : _parked) {
+                    if (!_active[id])
+                        _queued[id] = 0;
+                    else if (_state.level(id) < _max_level)
+                        push(id);
+                    else
+                        _parked[kept++] = id;
+                }
+                _parked.resize(kept);
+                return _size > 0 && getFront(item, true);
+            }
+            while (!_parked.empty()) {
+                int id = _parked.back();
+                _parked.pop_back();
+                _queued[id] = 0;
+                if (!_active[id])
+                    continue;
+                _active[id] = 0;
+                item = _graph->nodeFromId(id);
+                return true;
+            }
+            return false;
+        }
     private:
         
         int _init_level = 0;
-		bool is_initialized = false;
     public:
         
         void initStart() {
-            for(typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for(typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                _level[i] = -1;
+                _state.level(_graph->id(i)) = -1;
             }
+            _head = _size = 0;
+            _parked.clear();
+            std::fill(_active.begin(), _active.end(), 0);
+            std::fill(_queued.begin(), _queued.end(), 0);
+            _init_level = 0;
         }
         void initAddItem(Item i) {
-            _level[i] = _init_level;            
+            _state.level(_graph->id(i)) = _init_level;            
         }
         void initNewLevel() {
             ++_init_level;
         }
         void initFinish() {            
-            for (typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for (typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                if (_level[i] == -1) {
-                    _level[i] = _max_level;
+                if (_state.level(_graph->id(i)) == -1) {
+                    _state.level(_graph->id(i)) = _max_level;
                 }
             }
         }
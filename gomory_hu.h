@@ -0,0 +1,245 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <limits>
+#include <lemon/core.h>
+#include <lemon/list_graph.h>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "mf_base.h"
+
+namespace lemon {
+    // Gomory-Hu cut tree of a digraph taken as undirected, every arc is an
+    // edge of its capacity in both directions. The tree is built by Gusfield's
+    // algorithm with n - 1 maximum flows on a symmetric copy of the graph.
+    // The next sources are solved speculatively in parallel, one solver per
+    // thread that is reused for all its flows, and a result is kept as long as
+    // the tree parent it was solved against did not change meanwhile.
+    // Preflow_Parallel can be used as PF with batchSize(1).
+    template <typename GR,
+        typename CAP = typename GR::template ArcMap<int>,
+        typename PF = Preflow_HL<ListDigraph, ListDigraph::ArcMap<typename CAP::Value> > >
+    class GomoryHuTree {
+    public:
+        typedef GR Graph;
+        typedef CAP Capacity;
+        typedef typename Capacity::Value Value;
+        typedef PF Preflow;
+    private:
+        TEMPLATE_DIGRAPH_TYPEDEFS(Graph);
+        typedef ListDigraph::ArcMap<Value> SymCapacity;
+        typedef lemon::ResidualGraph<ListDigraph, Value> ResidualGraph;
+
+        const Graph& _graph;
+        const Capacity& _capacity;
+        // symmetric copy, node i of it is _nodes[i]
+        ListDigraph _sym;
+        SymCapacity _sym_cap;
+        std::vector<Node> _nodes;
+        IntNodeMap _index;
+        ResidualGraph _res;
+        std::vector<std::unique_ptr<Preflow> > _solvers;
+        int _batch_size;
+        // the cut tree: parent and the value of the edge to it, -1 at the root
+        std::vector<int> _pred;
+        std::vector<Value> _pred_value;
+        std::vector<int> _depth;
+        // nodes in the order of their depth
+        std::vector<int> _order;
+        // speculative results, one block of n per batch slot
+        std::vector<char> _cuts;
+        std::vector<Value> _values;
+        std::vector<int> _targets;
+        int _flow_num;
+
+        static int threadNum() {
+#if OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+        static int threadId() {
+#if OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        void solve(int slot, int s, int t) {
+            int n = int(_nodes.size());
+            Preflow& pf = *_solvers[threadId()];
+            pf.source(_sym.nodeFromId(s)).target(_sym.nodeFromId(t));
+            pf.init();
+            pf.startFirstPhase();
+            pf.startSecondPhase();
+            char* cut = &_cuts[(size_t)slot * n];
+            for (int i = 0; i < n; i++)
+                cut[i] = pf.minCut(_sym.nodeFromId(i));
+            _values[slot] = pf.flowValue();
+        }
+        void computeDepths() {
+            int n = int(_nodes.size());
+            _depth.assign(n, -1);
+            for (int i = 0; i < n; i++) {
+                // walk up to a node of known depth, then back down
+                int d = 0, v = i;
+                while (v != -1 && _depth[v] == -1) {
+                    v = _pred[v];
+                    d++;
+                }
+                int base = v == -1 ? -1 : _depth[v];
+                for (v = i; v != -1 && _depth[v] == -1; v = _pred[v])
+                    _depth[v] = base + d--;
+            }
+            std::vector<int> count(n + 1, 0);
+            for (int i = 0; i < n; i++)
+                count[_depth[i] + 1]++;
+            for (int d = 0; d < n; d++)
+                count[d + 1] += count[d];
+            _order.resize(n);
+            for (int i = 0; i < n; i++)
+                _order[count[_depth[i]]++] = i;
+        }
+
+    public:
+        GomoryHuTree(const Graph& graph, const Capacity& capacity)
+            : _graph(graph), _capacity(capacity), _sym_cap(_sym), _index(graph),
+            _batch_size(threadNum()), _flow_num(0) {}
+
+        // number of sources solved speculatively at once, the number of
+        // threads by default
+        GomoryHuTree& batchSize(int size) {
+            _batch_size = size < 1 ? 1 : size;
+            return *this;
+        }
+
+        void run() {
+            _nodes.clear();
+            _sym.clear();
+            for (NodeIt v(_graph); v != INVALID; ++v) {
+                _index[v] = int(_nodes.size());
+                _nodes.push_back(v);
+                _sym.addNode();
+            }
+            for (ArcIt e(_graph); e != INVALID; ++e) {
+                ListDigraph::Node u = _sym.nodeFromId(_index[_graph.source(e)]);
+                ListDigraph::Node v = _sym.nodeFromId(_index[_graph.target(e)]);
+                _sym_cap[_sym.addArc(u, v)] = _capacity[e];
+                _sym_cap[_sym.addArc(v, u)] = _capacity[e];
+            }
+            int n = int(_nodes.size());
+            _pred.assign(n, 0);
+            _pred_value.assign(n, 0);
+            _flow_num = 0;
+            if (n > 0)
+                _pred[0] = -1;
+            _res = ResidualGraph();
+            _res.build(_sym);
+            _solvers.clear();
+            int thread_num = threadNum();
+            _solvers.resize(thread_num);
+            for (int t = 0; t < thread_num; t++) {
+                _solvers[t].reset(new Preflow(_sym, _sym_cap, INVALID, INVALID));
+                _solvers[t]->shareResidualGraph(_res);
+            }
+            _cuts.resize((size_t)_batch_size * n);
+            _values.resize(_batch_size);
+            _targets.resize(_batch_size);
+
+            for (int first = 1; first < n;) {
+                int batch = n - first < _batch_size ? n - first : _batch_size;
+                for (int k = 0; k < batch; k++)
+                    _targets[k] = _pred[first + k];
+                #pragma omp parallel for schedule(dynamic)
+                for (int k = 0; k < batch; k++)
+                    solve(k, first + k, _targets[k]);
+                _flow_num += batch;
+                // apply the results in order while they are still valid
+                int k = 0;
+                for (; k < batch; k++) {
+                    int s = first + k;
+                    int t = _pred[s];
+                    if (t != _targets[k])
+                        break;
+                    const char* cut = &_cuts[(size_t)k * n];
+                    Value value = _values[k];
+                    _pred_value[s] = value;
+                    for (int i = 0; i < n; i++) {
+                        if (i != s && cut[i] && _pred[i] == t)
+                            _pred[i] = s;
+                    }
+                    if (_pred[t] != -1 && cut[_pred[t]]) {
+                        _pred[s] = _pred[t];
+                        _pred[t] = s;
+                        _pred_value[s] = _pred_value[t];
+                        _pred_value[t] = value;
+                    }
+                }
+                first += k;
+            }
+            computeDepths();
+        }
+
+        // number of maximum flows computed by run(), speculative ones included
+        int flowNum() const {
+            return _flow_num;
+        }
+        // parent of the node in the tree, INVALID at the root
+        Node predNode(const Node& node) const {
+            int p = _pred[_index[node]];
+            return p == -1 ? INVALID : _nodes[p];
+        }
+        // capacity of the tree edge to the parent
+        Value predValue(const Node& node) const {
+            return _pred_value[_index[node]];
+        }
+        int rootDist(const Node& node) const {
+            return _depth[_index[node]];
+        }
+        // minimum cut value between two nodes, the smallest edge on their
+        // tree path
+        Value minCutValue(const Node& s, const Node& t) const {
+            int u = _index[s], v = _index[t];
+            Value value = std::numeric_limits<Value>::max();
+            while (u != v) {
+                if (_depth[u] >= _depth[v]) {
+                    if (_pred_value[u] < value)
+                        value = _pred_value[u];
+                    u = _pred[u];
+                }
+                else {
+                    if (_pred_value[v] < value)
+                        value = _pred_value[v];
+                    v = _pred[v];
+                }
+            }
+            return value;
+        }
+        // the nodes on the side of s of a minimum s-t cut, returns the cut value
+        template <typename CutMap>
+        Value minCutMap(const Node& s, const Node& t, CutMap& cut) const {
+            int u = _index[s], v = _index[t];
+            int edge = -1;
+            Value value = std::numeric_limits<Value>::max();
+            while (u != v) {
+                int& w = _depth[u] >= _depth[v] ? u : v;
+                if (_pred_value[w] < value) {
+                    value = _pred_value[w];
+                    edge = w;
+                }
+                w = _pred[w];
+            }
+            // the subtree below the minimum edge is one side
+            std::vector<char> below(_nodes.size(), 0);
+            for (int i : _order)
+                below[i] = i == edge || (_pred[i] != -1 && below[_pred[i]]);
+            char s_side = below[_index[s]];
+            for (int i = 0; i < int(_nodes.size()); i++)
+                cut.set(_nodes[i], below[i] == s_side);
+            return value;
+        }
+    };
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <boost/program_options.hpp>
+#include <lemon/lgf_reader.h>
+#include <lemon/list_graph.h>
+#include "dimacs_io.h"
+#include "mapped_digraph.h"
+
+// read an LGF or DIMACS graph and write it as a binary graph file
+template <typename T>
+void convert(const std::string& input, const std::string& format, const std::string& output) {
+	typedef lemon::ListDigraph Digraph;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef Digraph::Node Node;
+	std::ifstream fin(input);
+	if (!fin)
+		throw lemon::IoError("Cannot open file", input);
+	Digraph digraph;
+	ArcMap cap(digraph);
+	Node src, trg;
+	if (format == "dimacs") {
+		lemon::readDimacsMaxFlow(fin, digraph, cap, src, trg);
+	}
+	else {
+		lemon::digraphReader(digraph, fin)
+			.arcMap("capacity", cap)
+			.node("source", src)
+			.node("target", trg)
+			.run();
+	}
+	lemon::writeBinaryDigraph(output, digraph, cap, src, trg);
+}
+int main(int argc, const char *argv[]){
+	boost::program_options::options_description desc;
+	desc.add_options()
+		("help,h", "Show this help screen")
+		("input", boost::program_options::value<std::string>(), "input graph file name")
+		("output", boost::program_options::value<std::string>(), "output binary graph file name (.pfg)")
+		("format", boost::program_options::value<std::string>()->default_value("auto"),
+			"input format: lgf, dimacs or auto (dimacs for .dimac, .dimacs and .max files)")
+		("value_type", boost::program_options::value<std::string>()->default_value("double"),
+			"capacity type stored in the file: double, int32 or int64");
+
+	boost::program_options::variables_map vm;
+	try{
+		boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+		boost::program_options::notify(vm);
+	}
+	catch (const boost::program_options::error & ex) {
+		std::cerr << ex.what() << '\n';
+		return 1;
+	}
+	if (vm.count("help") || !vm.count("input") || !vm.count("output")) {
+		std::cout << desc << '\n';
+		return 0;
+	}
+	std::string input = vm["input"].as<std::string>();
+	std::string output = vm["output"].as<std::string>();
+	std::string format = vm["format"].as<std::string>();
+	std::string value_type = vm["value_type"].as<std::string>();
+	if (format == "auto") {
+		std::string ext = input.substr(input.find_last_of('.') + 1);
+		format = (ext == "dimac" || ext == "dimacs" || ext == "max") ? "dimacs" : "lgf";
+	}
+	if (format != "lgf" && format != "dimacs") {
+		std::cerr << "unknown graph file format: " << format << '\n';
+		return 1;
+	}
+	if (value_type != "int32" && value_type != "int64" && value_type != "double") {
+		std::cerr << "unknown capacity type: " << value_type << '\n';
+		return 1;
+	}
+	try {
+		if (value_type == "int32")
+			convert<std::int32_t>(input, format, output);
+		else if (value_type == "int64")
+			convert<std::int64_t>(input, format, output);
+		else
+			convert<double>(input, format, output);
+	}
+	catch (const lemon::Exception & ex) {
+		std::cerr << ex.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
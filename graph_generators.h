@@ -0,0 +1,194 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <lemon/core.h>
+
+namespace lemon {
+    // generators of the standard maximum flow benchmark families. Each one
+    // adds nodes and arcs to an empty digraph, sets the capacities and
+    // returns the source and the target. Equal seeds give equal graphs.
+
+    // genrmf (Goldfarb and Grigoriadis): b frames of a x a grids. Inside a
+    // frame every node is joined to its grid neighbours with capacity
+    // c2 * a * a, between consecutive frames each node has one arc to a node
+    // of a random permutation of the next frame with capacity in [c1, c2].
+    // The source is the first node of the first frame, the target the last
+    // node of the last frame.
+    template <typename Digraph, typename CapacityMap>
+    void genrmf(Digraph& g, CapacityMap& cap, typename Digraph::Node& s, typename Digraph::Node& t,
+        int a, int b, int c1, int c2, unsigned seed) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> frame_cap(c1, c2);
+        std::vector<Node> nodes(a * a * b);
+        for (int i = 0; i < int(nodes.size()); i++)
+            nodes[i] = g.addNode();
+        Value inner = Value(c2) * a * a;
+        std::vector<int> perm(a * a);
+        for (int f = 0; f < b; f++) {
+            Node* frame = &nodes[f * a * a];
+            for (int x = 0; x < a; x++) {
+                for (int y = 0; y < a; y++) {
+                    int v = x * a + y;
+                    if (x > 0) cap.set(g.addArc(frame[v], frame[v - a]), inner);
+                    if (x + 1 < a) cap.set(g.addArc(frame[v], frame[v + a]), inner);
+                    if (y > 0) cap.set(g.addArc(frame[v], frame[v - 1]), inner);
+                    if (y + 1 < a) cap.set(g.addArc(frame[v], frame[v + 1]), inner);
+                }
+            }
+            if (f + 1 == b)
+                continue;
+            for (int v = 0; v < a * a; v++)
+                perm[v] = v;
+            std::shuffle(perm.begin(), perm.end(), rng);
+            for (int v = 0; v < a * a; v++)
+                cap.set(g.addArc(frame[v], nodes[(f + 1) * a * a + perm[v]]), Value(frame_cap(rng)));
+        }
+        s = nodes.front();
+        t = nodes.back();
+    }
+
+    // Washington random level graph: a rows x cols grid of levels, every node
+    // has arcs to three random nodes of the next column with capacity in
+    // [1, range]. The source feeds the first column and the last column
+    // drains into the target, both with capacity rows * range.
+    template <typename Digraph, typename CapacityMap>
+    void washingtonRLG(Digraph& g, CapacityMap& cap, typename Digraph::Node& s, typename Digraph::Node& t,
+        int rows, int cols, int range, unsigned seed) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> row(0, rows - 1);
+        std::uniform_int_distribution<int> arc_cap(1, range);
+        s = g.addNode();
+        std::vector<Node> nodes(rows * cols);
+        for (int i = 0; i < int(nodes.size()); i++)
+            nodes[i] = g.addNode();
+        t = g.addNode();
+        Value big = Value(rows) * range;
+        for (int r = 0; r < rows; r++) {
+            cap.set(g.addArc(s, nodes[r]), big);
+            cap.set(g.addArc(nodes[(cols - 1) * rows + r], t), big);
+        }
+        for (int c = 0; c + 1 < cols; c++) {
+            for (int r = 0; r < rows; r++) {
+                for (int k = 0; k < 3; k++)
+                    cap.set(g.addArc(nodes[c * rows + r], nodes[(c + 1) * rows + row(rng)]),
+                        Value(arc_cap(rng)));
+            }
+        }
+    }
+
+    // AK networks (Cherkassky and Goldberg), hard for push-relabel, with
+    // 4k + 6 nodes. The first module is a path of k + 1 nodes with decreasing
+    // capacities where every node sends one unit to the target through a
+    // private node, the second module is a path which feeds k parallel two-arc
+    // paths of decreasing capacity. Both modules hang off the source.
+    template <typename Digraph, typename CapacityMap>
+    void akNetwork(Digraph& g, CapacityMap& cap, typename Digraph::Node& s, typename Digraph::Node& t, int k) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        s = g.addNode();
+        t = g.addNode();
+        // first module
+        Node prev = g.addNode();
+        cap.set(g.addArc(s, prev), Value(k + 1));
+        for (int i = 0; i <= k; i++) {
+            Node side = g.addNode();
+            cap.set(g.addArc(prev, side), Value(1));
+            cap.set(g.addArc(side, t), Value(1));
+            if (i == k)
+                break;
+            Node next = g.addNode();
+            cap.set(g.addArc(prev, next), Value(k - i));
+            prev = next;
+        }
+        // second module
+        Node head = g.addNode();
+        cap.set(g.addArc(s, head), Value(k + 1));
+        Node tail = g.addNode();
+        cap.set(g.addArc(tail, t), Value(k + 1));
+        for (int i = 0; i < k; i++) {
+            Node next = g.addNode();
+            cap.set(g.addArc(head, next), Value(k + 1));
+            Node mid = g.addNode();
+            cap.set(g.addArc(head, mid), Value(1));
+            cap.set(g.addArc(mid, tail), Value(1));
+            head = next;
+        }
+        cap.set(g.addArc(head, tail), Value(1));
+    }
+
+    // vision style grid of width x height pixels, 4 or 8 connected. Neighbours
+    // are joined in both directions with a random smoothness capacity in
+    // [1, range], every pixel gets a random data term in [-range, range]
+    // which is an arc from the source if positive and to the target otherwise.
+    template <typename Digraph, typename CapacityMap>
+    void visionGrid(Digraph& g, CapacityMap& cap, typename Digraph::Node& s, typename Digraph::Node& t,
+        int width, int height, int connectivity, int range, unsigned seed) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> smooth(1, range);
+        std::uniform_int_distribution<int> data(-range, range);
+        s = g.addNode();
+        t = g.addNode();
+        std::vector<Node> pixels(width * height);
+        for (int i = 0; i < int(pixels.size()); i++)
+            pixels[i] = g.addNode();
+        const int dx[4] = { 1, 0, 1, 1 };
+        const int dy[4] = { 0, 1, 1, -1 };
+        int dirs = connectivity == 8 ? 4 : 2;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                Node p = pixels[y * width + x];
+                for (int d = 0; d < dirs; d++) {
+                    int nx = x + dx[d], ny = y + dy[d];
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                        continue;
+                    Node q = pixels[ny * width + nx];
+                    Value c = Value(smooth(rng));
+                    cap.set(g.addArc(p, q), c);
+                    cap.set(g.addArc(q, p), c);
+                }
+                int d = data(rng);
+                if (d > 0)
+                    cap.set(g.addArc(s, p), Value(d));
+                else if (d < 0)
+                    cap.set(g.addArc(p, t), Value(-d));
+            }
+        }
+    }
+
+    // dense affinity graph of n points of a 2D standard normal blob, i < j are
+    // joined by an arc of capacity exp(-gamma * |p_i - p_j|^2) if it exceeds
+    // tolerance. The source is the first point and the target the last one.
+    template <typename Digraph, typename CapacityMap>
+    void rbfGraph(Digraph& g, CapacityMap& cap, typename Digraph::Node& s, typename Digraph::Node& t,
+        int n, double gamma, unsigned seed, double tolerance = 1e-10) {
+        typedef typename Digraph::Node Node;
+        typedef typename CapacityMap::Value Value;
+        std::mt19937 rng(seed);
+        std::normal_distribution<double> normal(0, 1);
+        std::vector<double> x(n), y(n);
+        std::vector<Node> nodes(n);
+        for (int i = 0; i < n; i++) {
+            x[i] = normal(rng);
+            y[i] = normal(rng);
+            nodes[i] = g.addNode();
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                double d2 = (x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]);
+                double w = std::exp(-gamma * d2);
+                if (w > tolerance)
+                    cap.set(g.addArc(nodes[i], nodes[j]), Value(w));
+            }
+        }
+        s = nodes.front();
+        t = nodes.back();
+    }
+}
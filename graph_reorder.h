@@ -0,0 +1,184 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <lemon/core.h>
+#include <lemon/list_graph.h>
+#include <lemon/error.h>
+
+namespace lemon {
+    // node numberings of ReorderedDigraph. The solvers keep their per node
+    // state and the residual arcs by node id, so neighbours with close ids
+    // share cache lines in a discharge.
+    enum NodeOrder {
+        // the order of the node ids of the input
+        ORDER_NONE,
+        // breadth-first from the target over the arcs in both directions,
+        // the order in which the first global relabel reaches the nodes
+        ORDER_BFS,
+        // reverse Cuthill-McKee, a breadth-first order from a node of
+        // smallest degree visiting neighbours by increasing degree, reversed,
+        // it keeps the id distance of adjacent nodes small
+        ORDER_RCM,
+        // by decreasing degree, the hubs share the first cache lines
+        ORDER_DEGREE
+    };
+
+    // parse none, bfs, rcm or degree
+    inline NodeOrder nodeOrder(const std::string& name) {
+        if (name == "none")
+            return ORDER_NONE;
+        if (name == "bfs")
+            return ORDER_BFS;
+        if (name == "rcm")
+            return ORDER_RCM;
+        if (name == "degree")
+            return ORDER_DEGREE;
+        throw FormatError("unknown node order: " + name);
+    }
+
+    // ids of the nodes of the graph in the given order, the k-th one becomes
+    // node k. Nodes not reached from the target are appended component by
+    // component.
+    template <typename GR>
+    std::vector<int> nodeOrder(const GR& graph, typename GR::Node target, NodeOrder order) {
+        TEMPLATE_DIGRAPH_TYPEDEFS(GR);
+        int id_num = graph.maxNodeId() + 1;
+        std::vector<int> ids;
+        for (NodeIt n(graph); n != INVALID; ++n)
+            ids.push_back(graph.id(n));
+        std::sort(ids.begin(), ids.end());
+        if (order == ORDER_NONE)
+            return ids;
+        std::vector<int> degree(id_num, 0);
+        for (ArcIt e(graph); e != INVALID; ++e) {
+            degree[graph.id(graph.source(e))]++;
+            degree[graph.id(graph.target(e))]++;
+        }
+        if (order == ORDER_DEGREE) {
+            std::stable_sort(ids.begin(), ids.end(),
+                [&degree](int a, int b) { return degree[a] > degree[b]; });
+            return ids;
+        }
+        // seeds of the breadth-first searches, the first unreached one
+        // starts the next component
+        std::vector<int> seeds;
+        if (order == ORDER_BFS) {
+            if (target != INVALID)
+                seeds.push_back(graph.id(target));
+            seeds.insert(seeds.end(), ids.begin(), ids.end());
+        }
+        else {
+            seeds = ids;
+            std::stable_sort(seeds.begin(), seeds.end(),
+                [&degree](int a, int b) { return degree[a] < degree[b]; });
+        }
+        std::vector<char> reached(id_num, 0);
+        std::vector<int> queue;
+        queue.reserve(ids.size());
+        for (int seed : seeds) {
+            if (reached[seed])
+                continue;
+            reached[seed] = 1;
+            int head = int(queue.size());
+            queue.push_back(seed);
+            for (; head < int(queue.size()); head++) {
+                Node n = graph.nodeFromId(queue[head]);
+                int first = int(queue.size());
+                for (OutArcIt e(graph, n); e != INVALID; ++e) {
+                    int id = graph.id(graph.target(e));
+                    if (!reached[id]) {
+                        reached[id] = 1;
+                        queue.push_back(id);
+                    }
+                }
+                for (InArcIt e(graph, n); e != INVALID; ++e) {
+                    int id = graph.id(graph.source(e));
+                    if (!reached[id]) {
+                        reached[id] = 1;
+                        queue.push_back(id);
+                    }
+                }
+                if (order == ORDER_RCM)
+                    std::stable_sort(queue.begin() + first, queue.end(),
+                        [&degree](int a, int b) { return degree[a] < degree[b]; });
+            }
+        }
+        if (order == ORDER_RCM)
+            std::reverse(queue.begin(), queue.end());
+        return queue;
+    }
+
+    // copy of a digraph with its nodes renumbered in a NodeOrder, the arcs
+    // are added by the new id of their source. The solvers run on graph()
+    // and capacityMap(), node() and arc() translate the original items and
+    // minCutMap() and flowMap() return a result on the original graph.
+    template <typename GR, typename CAP = typename GR::template ArcMap<int> >
+    class ReorderedDigraph {
+    public:
+        typedef GR Graph;
+        typedef CAP Capacity;
+        typedef typename Capacity::Value Value;
+        typedef ListDigraph Digraph;
+        typedef ListDigraph::ArcMap<Value> CapacityMap;
+    private:
+        TEMPLATE_DIGRAPH_TYPEDEFS(Graph);
+
+        const Graph& _original;
+        ListDigraph _graph;
+        CapacityMap _capacity;
+        typename Graph::template NodeMap<ListDigraph::Node> _node_ref;
+        typename Graph::template ArcMap<ListDigraph::Arc> _arc_ref;
+        // original node of every node of _graph, by id
+        std::vector<Node> _original_node;
+        ListDigraph::Node _source, _target;
+    public:
+        ReorderedDigraph(const Graph& graph, const Capacity& capacity,
+            Node source, Node target, NodeOrder order)
+            : _original(graph), _capacity(_graph), _node_ref(graph), _arc_ref(graph) {
+            std::vector<int> ids = nodeOrder(graph, target, order);
+            _original_node.reserve(ids.size());
+            for (int id : ids) {
+                Node n = graph.nodeFromId(id);
+                _node_ref[n] = _graph.addNode();
+                _original_node.push_back(n);
+            }
+            for (Node n : _original_node) {
+                for (OutArcIt e(graph, n); e != INVALID; ++e) {
+                    ListDigraph::Arc a = _graph.addArc(_node_ref[n], _node_ref[graph.target(e)]);
+                    _arc_ref[e] = a;
+                    _capacity.set(a, capacity[e]);
+                }
+            }
+            _source = source != INVALID ? _node_ref[source] : INVALID;
+            _target = target != INVALID ? _node_ref[target] : INVALID;
+        }
+
+        const ListDigraph& graph() const { return _graph; }
+        const CapacityMap& capacityMap() const { return _capacity; }
+        ListDigraph::Node source() const { return _source; }
+        ListDigraph::Node target() const { return _target; }
+
+        // the node or arc of graph() of an original one
+        ListDigraph::Node node(Node n) const { return _node_ref[n]; }
+        ListDigraph::Arc arc(Arc a) const { return _arc_ref[a]; }
+        // the original node of a node of graph()
+        Node originalNode(ListDigraph::Node n) const {
+            return _original_node[_graph.id(n)];
+        }
+
+        // source side of the minimum cut of a solver run on graph(), set on
+        // the original nodes
+        template <typename PF, typename CutMap>
+        void minCutMap(const PF& preflow, CutMap& cut) const {
+            for (NodeIt n(_original); n != INVALID; ++n)
+                cut.set(n, preflow.minCut(_node_ref[n]));
+        }
+        // flow of a solver run on graph(), set on the original arcs
+        template <typename PF, typename FlowMap>
+        void flowMap(const PF& preflow, FlowMap& flow) const {
+            for (ArcIt e(_original); e != INVALID; ++e)
+                flow.set(e, preflow.flow(_arc_ref[e]));
+        }
+    };
+}
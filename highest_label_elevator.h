@@ -1,109 +1,256 @@
 #include <vector>
+#include <algorithm>
+#include "node_state.h"
 namespace lemon {
-    template<class GR, class Item>
-    class HLElevator {        
+    template<class GR, class Item, class State = PackedNodeState<int> >
+    class HLElevator {
 
     public:
         typedef int Value;
-        typedef typename std::list<Item>::iterator iterator;
         typedef typename GR::NodeIt NodeIt;
+        typedef State NodeState;
     private:
         typedef typename ItemSetTraits<GR, Item>::
             template Map<int>::Type IntMap;
         typedef typename ItemSetTraits<GR, Item>::
             template Map<bool>::Type BoolMap;
 
-        const GR& _graph;
+        const GR* _graph;
         int _max_level;
-        int highest_active_level = 0;
-        IntMap _level;
-        std::vector<std::list<Item>> hl_list;
+        State _state;
+        // active items are kept in intrusive doubly linked lists per level,
+        // indexed by item id, -1 ends a list
+        std::vector<int> _active_first;
+        std::vector<int> _active_prev, _active_next;
+        std::vector<char> _active;
+        // highest level with an active item, and the same below _max_level
+        int highest_active_level = -1;
+        int highest_active_level_limited = -1;
+        // all items, active or not, are kept in a doubly linked list per level,
+        // indexed by item id as well
+        std::vector<int> _level_count;
+        std::vector<int> _first;
+        std::vector<int> _prev, _next;
+        // no item below _max_level is above this level
+        int _highest_level = 0;
+        // items put on _max_level or above, recorded if _log_lifted is set
+        bool _log_lifted = false;
+        std::vector<int> _lifted;
 
-    public:
-        HLElevator(const GR& graph, int max_level)
-            : _graph(graph), _max_level(max_level),
-            _level(graph), _init_level(0) {
-            hl_list.resize(max_level * 2);
+        void link(int i, int level) {
+            if (_log_lifted && level >= _max_level)
+                _lifted.push_back(i);
+            _prev[i] = -1;
+            _next[i] = _first[level];
+            if (_first[level] != -1)
+                _prev[_first[level]] = i;
+            _first[level] = i;
+            _level_count[level]++;
+            if (level < _max_level && level > _highest_level)
+                _highest_level = level;
         }
-
-        HLElevator(const HLElevator& ele) :
-            _graph(ele._graph), _max_level(ele._max_level), hl_list(ele.hl_list),
-            _level(ele._graph) {
-            for (NodeIt n(_graph); n != INVALID; ++n) {
-                _level[n] = ele._level[n];
-            }
+        void unlink(int i, int level) {
+            if (_prev[i] != -1)
+                _next[_prev[i]] = _next[i];
+            else
+                _first[level] = _next[i];
+            if (_next[i] != -1)
+                _prev[_next[i]] = _prev[i];
+            _level_count[level]--;
         }
 
-        void activate(Item i) {
-            int level = _level[i];
+        void linkActive(int id, int level) {
+            _active_prev[id] = -1;
+            _active_next[id] = _active_first[level];
+            if (_active_first[level] != -1)
+                _active_prev[_active_first[level]] = id;
+            _active_first[level] = id;
             if (level > highest_active_level)
                 highest_active_level = level;
             if (level < _max_level && level > highest_active_level_limited)
                 highest_active_level_limited = level;
-            hl_list[level].push_back(i);
         }
+        void unlinkActive(int id, int level) {
+            if (_active_prev[id] != -1)
+                _active_next[_active_prev[id]] = _active_next[id];
+            else
+                _active_first[level] = _active_next[id];
+            if (_active_next[id] != -1)
+                _active_prev[_active_next[id]] = _active_prev[id];
+        }
+        // move the highest active levels down to the next nonempty list
+        void dropEmptyLevels() {
+            while (highest_active_level >= 0 && _active_first[highest_active_level] == -1)
+                highest_active_level--;
+            if (highest_active_level_limited > highest_active_level)
+                highest_active_level_limited = highest_active_level;
+            while (highest_active_level_limited >= 0 &&
+                _active_first[highest_active_level_limited] == -1)
+                highest_active_level_limited--;
+        }
+
+    public:
+        HLElevator(const GR& graph, int max_level) : _init_level(0) {
+            reset(graph, max_level);
+        }
+
+        HLElevator(const HLElevator& ele) = default;
 
-        inline void deactivate(Item i) {
+        // rebind to a graph, the arrays keep their memory if it suffices
+        void reset(const GR& graph, int max_level) {
+            int item_num = graph.maxNodeId() + 1;
+            _graph = &graph;
+            _max_level = max_level;
+            _state.resize(item_num);
+            _active_first.assign(max_level * 2, -1);
+            _active_prev.assign(item_num, -1);
+            _active_next.assign(item_num, -1);
+            _active.assign(item_num, 0);
+            _level_count.assign(max_level * 2, 0);
+            _first.assign(max_level * 2, -1);
+            _prev.assign(item_num, -1);
+            _next.assign(item_num, -1);
+            _log_lifted = false;
+            _lifted.clear();
         }
 
-        inline bool active(Item i) const { return false; }
+        void activate(Item i) {
+            int id = _graph->id(i);
+            if (_active[id])
+                return;
+            _active[id] = 1;
+            linkActive(id, _state.level(id));
+        }
 
-        int operator[](Item i) const { return _level[i]; }
+        void deactivate(Item i) {
+            int id = _graph->id(i);
+            if (!_active[id])
+                return;
+            _active[id] = 0;
+            unlinkActive(id, _state.level(id));
+            dropEmptyLevels();
+        }
+
+        bool active(Item i) const { return _active[_graph->id(i)] != 0; }
+
+        int operator[](Item i) const { return _state.level(_graph->id(i)); }
 
         void lift(Item i, int new_level) {
-            _level[i] = new_level;
+            int id = _graph->id(i);
+            unlink(id, _state.level(id));
+            link(id, new_level);
+            if (_active[id]) {
+                unlinkActive(id, _state.level(id));
+                linkActive(id, new_level);
+                dropEmptyLevels();
+            }
+            _state.level(id) = new_level;
         }
 
         int maxLevel() const {
             return _max_level;
         }
+        // label, excess and current arc of the items, shared with the solver
+        State& nodeState() {
+            return _state;
+        }
 
-        bool get_node_with_highest_label(Item& item, bool limit_max_level = false) {
-            int* hal;
-            if (limit_max_level)
-                hal = &highest_active_level_limited;
-            else
-                hal = &highest_active_level;
-            if (*hal < 0)
-                return false;
-            std::list<Item>* item_list;
-            while (*hal >= 0 ) {
-                item_list = &hl_list[*hal];
-                if(item_list->size() > 0)
-                    break;
-                (*hal)--;                
+        // number of items on the given level
+        int levelCount(int level) const {
+            return _level_count[level];
+        }
+
+        bool emptyLevel(int level) const {
+            return _level_count[level] == 0;
+        }
+
+        // lift all items on and above the given level but below maxLevel()
+        // to maxLevel(), used for the gap heuristic
+        void liftToTop(int level) {
+            for (int l = level; l <= _highest_level; l++) {
+                while (_first[l] != -1) {
+                    int id = _first[l];
+                    unlink(id, l);
+                    link(id, _max_level);
+                    _state.level(id) = _max_level;
+                }
+                while (_active_first[l] != -1) {
+                    int id = _active_first[l];
+                    unlinkActive(id, l);
+                    linkActive(id, _max_level);
+                }
             }
-            if (*hal < 0)
+            if (_highest_level >= level)
+                _highest_level = level - 1;
+            dropEmptyLevels();
+        }
+
+        // record the ids of the items put on maxLevel() or above from now on,
+        // an item is recorded again each time it is put there. A solver kept
+        // between instances finds the nodes which joined the source side from
+        // the record instead of scanning all nodes.
+        void logLifted(bool log) {
+            _log_lifted = log;
+            _lifted.clear();
+        }
+        const std::vector<int>& lifted() const {
+            return _lifted;
+        }
+        void clearLifted() {
+            _lifted.clear();
+        }
+
+        // take an active item from the highest level, below maxLevel() if
+        // limit_max_level is set, the item is no longer active afterwards
+        bool get_node_with_highest_label(Item& item, bool limit_max_level = false) {
+            int level = limit_max_level ? highest_active_level_limited : highest_active_level;
+            if (level < 0)
                 return false;
-            item = item_list->front();
-            item_list->pop_front();
+            int id = _active_first[level];
+            unlinkActive(id, level);
+            _active[id] = 0;
+            dropEmptyLevels();
+            item = _graph->nodeFromId(id);
             return true;
         }
     private:
 
         int _init_level = 0;
-        int highest_active_level_limited = 0;
     public:
 
         void initStart() {
-            for (typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for (typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                _level[i] = -1;
+                _state.level(_graph->id(i)) = -1;
+            }
+            for (int l = 0; l < int(_active_first.size()); l++) {
+                _active_first[l] = -1;
+                _level_count[l] = 0;
+                _first[l] = -1;
             }
+            std::fill(_active.begin(), _active.end(), 0);
+            highest_active_level = -1;
+            highest_active_level_limited = -1;
+            _highest_level = 0;
+            _init_level = 0;
         }
         void initAddItem(Item i) {
-            _level[i] = _init_level;
+            int id = _graph->id(i);
+            _state.level(id) = _init_level;
+            link(id, _init_level);
         }
         void initNewLevel() {
             ++_init_level;
         }
         void initFinish() {
-            for (typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for (typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                if (_level[i] == -1) {
-                    _level[i] = _max_level;
+                int id = _graph->id(i);
+                if (_state.level(id) == -1) {
+                    _state.level(id) = _max_level;
+                    link(id, _max_level);
                 }
             }
         }
     };
-}
\ No newline at end of file
+}
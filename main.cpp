@@ -2,66 +2,32 @@
 #include <fstream>
 #include <sstream>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
 #include <boost/program_options.hpp>
 #include <lemon/lgf_reader.h>
 #include <lemon/list_graph.h>
 #include <lemon/preflow.h>
 #include "mf_base.h"
-int main(int argc, const char *argv[]){
-    boost::program_options::options_description desc;
-	desc.add_options()
-		("help,h", "Show this help screen")
-		("filename", boost::program_options::value<std::string>(), "lgf file name")
-		("method", boost::program_options::value<std::string>()->default_value("hl"),
-			"maxflow implementation: rtf, hl, fifo, o_hl, pg")
-		("timing", boost::program_options::value<bool>()->implicit_value(true)->default_value(false),
-			"whether to timing the algorithm")
-		("print_cut", boost::program_options::value<bool>()->implicit_value(true)->default_value(false), "whether to print the min cut set of source side");
+#include "dimacs_io.h"
+#include "mapped_digraph.h"
+#include "graph_reorder.h"
 
-	boost::program_options::command_line_parser parser{ argc, argv };
-	parser.options(desc);
-	boost::program_options::variables_map vm;
-
-	try{
-		boost::program_options::parsed_options parsed_options = parser.run();
-		boost::program_options::store(parsed_options, vm);
-		boost::program_options::notify(vm);
-	}
-	catch (const boost::program_options::error & ex) {
-		std::cerr << ex.what() << '\n';
-	}
-	if (vm.count("help") || !vm.count("filename")) {
-		std::cout << desc << '\n';
-		return 0;
-	}
-	std::string filename;
-	std::string method_short_name;
-	bool print_cut, timing;
-	try{
-		method_short_name = vm["method"].as<std::string>();
-		print_cut = vm["print_cut"].as<bool>();
-		timing = vm["timing"].as<bool>();
-		filename = vm["filename"].as<std::string>();
-	}
-	catch (const boost::program_options::error & ex) {
-		std::cerr << ex.what() << '\n';
-	}
-	std::ifstream fin(filename);
-
-	typedef lemon::ListDigraph Digraph;
-	typedef double T;
-	typedef Digraph::ArcMap<T> ArcMap;
-	typedef Digraph::Node Node;
-	typedef Digraph::NodeIt NodeIt;
-
-	Digraph digraph;
-	ArcMap cap(digraph);
-	Node src, trg;
-	lemon::digraphReader(digraph, fin)
-		.arcMap("capacity", cap)
-		.node("source", src)
-		.node("target", trg)
-		.run();
+template <typename Digraph>
+int nodeLabel(const Digraph& digraph, typename Digraph::Node n, const std::vector<int>& original_id) {
+	int id = digraph.id(n);
+	return original_id.empty() ? id : original_id[id];
+}
+// run the chosen maximum flow implementation and print the result, the cut
+// is printed with original_id[id] of the nodes if the graph was reordered
+template <typename Digraph, typename ArcMap>
+void compute(const Digraph& digraph, const ArcMap& cap,
+	typename Digraph::Node src, typename Digraph::Node trg, const std::string& method_short_name,
+	double global_relabel_freq, bool print_cut, bool timing,
+	const std::vector<int>& original_id = std::vector<int>()) {
+	typedef typename Digraph::NodeIt NodeIt;
 	double max_flow_value;
 	std::string method_name;
 	std::stringstream cut_set;
@@ -72,33 +38,36 @@ int main(int argc, const char *argv[]){
 	
 	if (method_short_name == "hl") {
 		lemon::Preflow_HL<Digraph, ArcMap> alg(digraph, cap, src, trg);
+		alg.globalRelabelFrequency(global_relabel_freq);
 		method_name = "highest label";
 		start_time = std::chrono::system_clock::now();
 		alg.run();
 		max_flow_value = alg.flowValue();
 		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
 			if (alg.minCut(n))
-				cut_set << digraph.id(n) << ',';
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
 		}
 	} else if (method_short_name == "rtf") {
 		lemon::Preflow_Relabel<Digraph, ArcMap> alg(digraph, cap, src, trg);
+		alg.globalRelabelFrequency(global_relabel_freq);
 		method_name = "relabel to front";
 		start_time = std::chrono::system_clock::now();
 		alg.run();
 		max_flow_value = alg.flowValue();
 		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
 			if (alg.minCut(n))
-				cut_set << digraph.id(n) << ',';
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
 		}
 	} else if (method_short_name == "fifo") {
 		lemon::Preflow_FIFO<Digraph, ArcMap> alg(digraph, cap, src, trg);
+		alg.globalRelabelFrequency(global_relabel_freq);
 		method_name = "first in first out";
 		start_time = std::chrono::system_clock::now();
 		alg.run();
 		max_flow_value = alg.flowValue();
 		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
 			if (alg.minCut(n))
-				cut_set << digraph.id(n) << ',';
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
 		}
 	} else if (method_short_name == "o_hl") {
 		lemon::Preflow<Digraph, ArcMap> alg(digraph, cap, src, trg);
@@ -108,7 +77,17 @@ int main(int argc, const char *argv[]){
 		max_flow_value = alg.flowValue();
 		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
 			if (alg.minCut(n))
-				cut_set << digraph.id(n) << ',';
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
+		}
+	} else if (method_short_name == "async") {
+		lemon::Preflow_Async<Digraph, ArcMap> alg(digraph, cap, src, trg);
+		method_name = "asynchronous parallel";
+		start_time = std::chrono::system_clock::now();
+		alg.run();
+		max_flow_value = alg.flowValue();
+		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
+			if (alg.minCut(n))
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
 		}
 	} else {
 		lemon::Preflow_Parallel<Digraph, ArcMap> alg(digraph, cap, src, trg);
@@ -118,7 +97,7 @@ int main(int argc, const char *argv[]){
 		max_flow_value = alg.flowValue();
 		for (NodeIt n(digraph); n != lemon::INVALID; ++n) {
 			if (alg.minCut(n))
-				cut_set << digraph.id(n) << ',';
+				cut_set << nodeLabel(digraph, n, original_id) << ',';
 		}
 	}
 	end_time = std::chrono::system_clock::now();
@@ -136,5 +115,212 @@ int main(int argc, const char *argv[]){
         time_used = std::chrono::duration_cast<std::chrono::milliseconds>(dtn).count()/1000.0;
 		std::cout << "time used " << time_used << "s" << std::endl;
 	}
-	return 0;
+}
+// smallest capacity type which holds every capacity and every excess
+// exactly: int32 or int64 for integral capacities, double otherwise. An
+// excess is at most the capacity leaving the source.
+template <typename Digraph, typename ArcMap>
+std::string detectValueType(const Digraph& digraph, const ArcMap& cap, typename Digraph::Node src) {
+	double max_cap = 0, source_cap = 0;
+	for (typename Digraph::ArcIt e(digraph); e != lemon::INVALID; ++e) {
+		double c = cap[e];
+		if (c != std::floor(c) || c < 0)
+			return "double";
+		if (c > max_cap)
+			max_cap = c;
+		if (digraph.source(e) == src)
+			source_cap += c;
+	}
+	double bound = std::max(max_cap, source_cap);
+	if (bound <= std::numeric_limits<std::int32_t>::max())
+		return "int32";
+	// below 2^53 the double sum above is exact
+	if (bound < 9007199254740992.0)
+		return "int64";
+	return "double";
+}
+// copy the capacities to an integral map and run on it
+template <typename V, typename Digraph, typename ArcMap>
+void computeAs(const Digraph& digraph, const ArcMap& cap,
+	typename Digraph::Node src, typename Digraph::Node trg, const std::string& method_short_name,
+	double global_relabel_freq, bool print_cut, bool timing, const std::vector<int>& original_id) {
+	typename Digraph::template ArcMap<V> value_cap(digraph);
+	for (typename Digraph::ArcIt e(digraph); e != lemon::INVALID; ++e)
+		value_cap[e] = V(cap[e]);
+	compute(digraph, value_cap, src, trg, method_short_name, global_relabel_freq, print_cut, timing, original_id);
+}
+// pick the capacity type and run, false if the capacities do not fit into
+// the requested integral type
+template <typename Digraph, typename ArcMap>
+bool computeValueType(const Digraph& digraph, const ArcMap& cap,
+	typename Digraph::Node src, typename Digraph::Node trg, const std::string& method_short_name,
+	double global_relabel_freq, bool print_cut, bool timing, std::string value_type,
+	const std::vector<int>& original_id = std::vector<int>()) {
+	std::string detected = detectValueType(digraph, cap, src);
+	if (value_type == "auto")
+		value_type = detected;
+	else if ((value_type == "int32" && detected != "int32") ||
+		(value_type == "int64" && detected == "double")) {
+		std::cerr << "the capacities do not fit into " << value_type << ", use --value_type " << detected << '\n';
+		return false;
+	}
+	if (value_type == "int32")
+		computeAs<std::int32_t>(digraph, cap, src, trg, method_short_name, global_relabel_freq, print_cut, timing, original_id);
+	else if (value_type == "int64")
+		computeAs<std::int64_t>(digraph, cap, src, trg, method_short_name, global_relabel_freq, print_cut, timing, original_id);
+	else
+		compute(digraph, cap, src, trg, method_short_name, global_relabel_freq, print_cut, timing, original_id);
+	return true;
+}
+int main(int argc, const char *argv[]){
+    boost::program_options::options_description desc;
+	desc.add_options()
+		("help,h", "Show this help screen")
+		("filename", boost::program_options::value<std::string>(), "graph file name")
+		("format", boost::program_options::value<std::string>()->default_value("auto"),
+			"graph file format: lgf, dimacs, binary or auto (dimacs for .dimac, .dimacs and .max files, binary for .pfg files)")
+		("write_dimacs", boost::program_options::value<std::string>(),
+			"write the graph in DIMACS format to the given file")
+		("method", boost::program_options::value<std::string>()->default_value("hl"),
+			"maxflow implementation: rtf, hl, fifo, o_hl, pg, async")
+		("timing", boost::program_options::value<bool>()->implicit_value(true)->default_value(false),
+			"whether to timing the algorithm")
+		("global_relabel", boost::program_options::value<double>()->default_value(0),
+			"frequency of the global relabel heuristic for rtf, hl and fifo, 0 disables it")
+		("value_type", boost::program_options::value<std::string>()->default_value("auto"),
+			"capacity type: int32, int64, double or auto (integral kernels for integral capacities)")
+		("reorder", boost::program_options::value<std::string>()->default_value("none"),
+			"renumber the nodes of an lgf or dimacs graph for cache locality before solving: none, bfs (from the target), rcm (reverse Cuthill-McKee) or degree")
+		("print_cut", boost::program_options::value<bool>()->implicit_value(true)->default_value(false), "whether to print the min cut set of source side");
+
+	boost::program_options::command_line_parser parser{ argc, argv };
+	parser.options(desc);
+	boost::program_options::variables_map vm;
+
+	try{
+		boost::program_options::parsed_options parsed_options = parser.run();
+		boost::program_options::store(parsed_options, vm);
+		boost::program_options::notify(vm);
+	}
+	catch (const boost::program_options::error & ex) {
+		std::cerr << ex.what() << '\n';
+	}
+	if (vm.count("help") || !vm.count("filename")) {
+		std::cout << desc << '\n';
+		return 0;
+	}
+	std::string filename;
+	std::string method_short_name;
+	std::string format;
+	std::string value_type = "auto";
+	std::string reorder = "none";
+	bool print_cut, timing;
+	double global_relabel_freq = 0;
+	try{
+		method_short_name = vm["method"].as<std::string>();
+		print_cut = vm["print_cut"].as<bool>();
+		timing = vm["timing"].as<bool>();
+		global_relabel_freq = vm["global_relabel"].as<double>();
+		filename = vm["filename"].as<std::string>();
+		format = vm["format"].as<std::string>();
+		value_type = vm["value_type"].as<std::string>();
+		reorder = vm["reorder"].as<std::string>();
+	}
+	catch (const boost::program_options::error & ex) {
+		std::cerr << ex.what() << '\n';
+	}
+	typedef lemon::ListDigraph Digraph;
+	typedef double T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef Digraph::Node Node;
+
+	if (format == "auto") {
+		std::string ext = filename.substr(filename.find_last_of('.') + 1);
+		if (ext == "dimac" || ext == "dimacs" || ext == "max")
+			format = "dimacs";
+		else if (ext == "pfg")
+			format = "binary";
+		else
+			format = "lgf";
+	}
+	if (format != "lgf" && format != "dimacs" && format != "binary") {
+		std::cerr << "unknown graph file format: " << format << '\n';
+		return 1;
+	}
+	if (value_type != "auto" && value_type != "int32" && value_type != "int64" && value_type != "double") {
+		std::cerr << "unknown capacity type: " << value_type << '\n';
+		return 1;
+	}
+	if (format == "binary") {
+		try {
+			// the file stores its capacity type, value_type is not used
+			lemon::MappedDigraph mapped(filename);
+			if (mapped.valueType() == lemon::BinaryValueType<std::int32_t>::code) {
+				lemon::MappedDigraph::CapacityMap<std::int32_t> mapped_cap(mapped);
+				compute(mapped, mapped_cap, mapped.source(), mapped.target(),
+					method_short_name, global_relabel_freq, print_cut, timing);
+			}
+			else if (mapped.valueType() == lemon::BinaryValueType<std::int64_t>::code) {
+				lemon::MappedDigraph::CapacityMap<std::int64_t> mapped_cap(mapped);
+				compute(mapped, mapped_cap, mapped.source(), mapped.target(),
+					method_short_name, global_relabel_freq, print_cut, timing);
+			}
+			else {
+				lemon::MappedDigraph::CapacityMap<T> mapped_cap(mapped);
+				compute(mapped, mapped_cap, mapped.source(), mapped.target(),
+					method_short_name, global_relabel_freq, print_cut, timing);
+			}
+		}
+		catch (const lemon::Exception & ex) {
+			std::cerr << ex.what() << '\n';
+			return 1;
+		}
+		return 0;
+	}
+	std::ifstream fin(filename);
+	Digraph digraph;
+	ArcMap cap(digraph);
+	Node src, trg;
+	try {
+		if (format == "dimacs") {
+			lemon::readDimacsMaxFlow(fin, digraph, cap, src, trg);
+		}
+		else {
+			lemon::digraphReader(digraph, fin)
+				.arcMap("capacity", cap)
+				.node("source", src)
+				.node("target", trg)
+				.run();
+		}
+	}
+	catch (const lemon::FormatError & ex) {
+		std::cerr << ex.what() << '\n';
+		return 1;
+	}
+	if (vm.count("write_dimacs")) {
+		std::ofstream fout(vm["write_dimacs"].as<std::string>());
+		lemon::writeDimacsMaxFlow(fout, digraph, cap, src, trg);
+	}
+	if (reorder != "none") {
+		lemon::NodeOrder order;
+		try {
+			order = lemon::nodeOrder(reorder);
+		}
+		catch (const lemon::FormatError & ex) {
+			std::cerr << ex.what() << '\n';
+			return 1;
+		}
+		std::chrono::system_clock::time_point start_time = std::chrono::system_clock::now();
+		lemon::ReorderedDigraph<Digraph, ArcMap> reordered(digraph, cap, src, trg, order);
+		std::vector<int> original_id(digraph.maxNodeId() + 1);
+		for (lemon::ListDigraph::NodeIt n(reordered.graph()); n != lemon::INVALID; ++n)
+			original_id[reordered.graph().id(n)] = digraph.id(reordered.originalNode(n));
+		if (timing) {
+			std::chrono::system_clock::duration dtn = std::chrono::system_clock::now() - start_time;
+			std::cout << "reordering time " << std::chrono::duration_cast<std::chrono::milliseconds>(dtn).count()/1000.0 << "s" << std::endl;
+		}
+		return computeValueType(reordered.graph(), reordered.capacityMap(), reordered.source(), reordered.target(),
+			method_short_name, global_relabel_freq, print_cut, timing, value_type, original_id) ? 0 : 1;
+	}
+	return computeValueType(digraph, cap, src, trg, method_short_name, global_relabel_freq, print_cut, timing, value_type) ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,412 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <lemon/core.h>
+#include <lemon/error.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lemon {
+    // Binary max flow graph file, all integers in native byte order:
+    //   header       BinaryGraphHeader
+    //   out_first    int32[node_num + 1], arcs are numbered by source node
+    //   arc_target   int32[arc_num]
+    //   arc_source   int32[arc_num]
+    //   in_first     int32[node_num + 1]
+    //   in_arc       int32[arc_num], arc ids grouped by target node
+    //   capacity     Value[arc_num], starting at a multiple of 8 bytes
+    struct BinaryGraphHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t value_type;
+        std::int64_t node_num;
+        std::int64_t arc_num;
+        std::int64_t source;
+        std::int64_t target;
+    };
+    const char BINARY_GRAPH_MAGIC[8] = { 'P', 'F', 'G', 'R', 'A', 'P', 'H', '\0' };
+    const std::uint32_t BINARY_GRAPH_VERSION = 1;
+
+    // capacity type code stored in the header
+    template <typename V> struct BinaryValueType {};
+    template <> struct BinaryValueType<std::int32_t> { static const std::uint32_t code = 1; };
+    template <> struct BinaryValueType<std::int64_t> { static const std::uint32_t code = 2; };
+    template <> struct BinaryValueType<double> { static const std::uint32_t code = 3; };
+
+    namespace _binary_bits {
+        inline std::size_t align8(std::size_t pos) {
+            return (pos + 7) & ~std::size_t(7);
+        }
+        // byte offset of the capacity array
+        inline std::size_t capacityOffset(std::int64_t node_num, std::int64_t arc_num) {
+            return align8(sizeof(BinaryGraphHeader) +
+                sizeof(std::int32_t) * std::size_t(2 * (node_num + 1) + 3 * arc_num));
+        }
+    }
+
+    // write a digraph with its capacities, source and target into a binary graph file
+    template <typename Digraph, typename CapacityMap>
+    void writeBinaryDigraph(const std::string& filename, const Digraph& digraph,
+        const CapacityMap& capacity, typename Digraph::Node source, typename Digraph::Node target) {
+        typedef typename CapacityMap::Value Value;
+        typedef typename Digraph::NodeIt NodeIt;
+        typedef typename Digraph::OutArcIt OutArcIt;
+        typedef typename Digraph::InArcIt InArcIt;
+        typename Digraph::template NodeMap<std::int32_t> index(digraph);
+        typename Digraph::template ArcMap<std::int32_t> arc_index(digraph);
+        // nodes are numbered in the order of their ids, so that dense ids are kept
+        std::vector<typename Digraph::Node> nodes;
+        for (NodeIt v(digraph); v != INVALID; ++v)
+            nodes.push_back(v);
+        std::sort(nodes.begin(), nodes.end());
+        std::int32_t n = std::int32_t(nodes.size()), m = 0;
+        for (std::int32_t i = 0; i < n; i++)
+            index[nodes[i]] = i;
+        std::vector<std::int32_t> out_first(n + 1), in_first(n + 1);
+        std::vector<std::int32_t> arc_target, arc_source, in_arc;
+        std::vector<Value> cap;
+        for (std::int32_t i = 0; i < n; i++) {
+            const typename Digraph::Node& v = nodes[i];
+            out_first[i] = m;
+            for (OutArcIt e(digraph, v); e != INVALID; ++e) {
+                arc_index[e] = m++;
+                arc_source.push_back(index[v]);
+                arc_target.push_back(index[digraph.target(e)]);
+                cap.push_back(capacity[e]);
+            }
+        }
+        out_first[n] = m;
+        for (std::int32_t i = 0; i < n; i++) {
+            in_first[i] = std::int32_t(in_arc.size());
+            for (InArcIt e(digraph, nodes[i]); e != INVALID; ++e)
+                in_arc.push_back(arc_index[e]);
+        }
+        in_first[n] = m;
+
+        BinaryGraphHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, BINARY_GRAPH_MAGIC, sizeof(header.magic));
+        header.version = BINARY_GRAPH_VERSION;
+        header.value_type = BinaryValueType<Value>::code;
+        header.node_num = n;
+        header.arc_num = m;
+        header.source = index[source];
+        header.target = index[target];
+
+        std::ofstream os(filename.c_str(), std::ios::binary);
+        if (!os)
+            throw IoError("Cannot write file", filename);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(out_first.data()), sizeof(std::int32_t) * (n + 1));
+        os.write(reinterpret_cast<const char*>(arc_target.data()), sizeof(std::int32_t) * m);
+        os.write(reinterpret_cast<const char*>(arc_source.data()), sizeof(std::int32_t) * m);
+        os.write(reinterpret_cast<const char*>(in_first.data()), sizeof(std::int32_t) * (n + 1));
+        os.write(reinterpret_cast<const char*>(in_arc.data()), sizeof(std::int32_t) * m);
+        std::size_t pos = sizeof(header) + sizeof(std::int32_t) * std::size_t(2 * (n + 1) + 3 * m);
+        for (; pos != _binary_bits::capacityOffset(n, m); ++pos)
+            os.put('\0');
+        os.write(reinterpret_cast<const char*>(cap.data()), sizeof(Value) * m);
+        if (!os)
+            throw IoError("Cannot write file", filename);
+    }
+
+    // read-only digraph backed by a memory mapped binary graph file.
+    // Nodes and arcs are used in place, only node and arc maps allocate memory.
+    class MappedDigraph {
+    public:
+        typedef MappedDigraph Digraph;
+
+        class Node {
+            friend class MappedDigraph;
+        protected:
+            int _id;
+            explicit Node(int id) : _id(id) {}
+        public:
+            Node() {}
+            Node(Invalid) : _id(-1) {}
+            bool operator==(const Node& node) const { return _id == node._id; }
+            bool operator!=(const Node& node) const { return _id != node._id; }
+            bool operator<(const Node& node) const { return _id < node._id; }
+        };
+        class Arc {
+            friend class MappedDigraph;
+        protected:
+            int _id;
+            explicit Arc(int id) : _id(id) {}
+        public:
+            Arc() {}
+            Arc(Invalid) : _id(-1) {}
+            bool operator==(const Arc& arc) const { return _id == arc._id; }
+            bool operator!=(const Arc& arc) const { return _id != arc._id; }
+            bool operator<(const Arc& arc) const { return _id < arc._id; }
+        };
+
+        class NodeIt : public Node {
+            int _num;
+        public:
+            NodeIt() {}
+            NodeIt(Invalid) : Node(INVALID), _num(0) {}
+            explicit NodeIt(const MappedDigraph& digraph)
+                : Node(digraph._node_num > 0 ? 0 : -1), _num(digraph._node_num) {}
+            NodeIt(const MappedDigraph& digraph, const Node& node)
+                : Node(node), _num(digraph._node_num) {}
+            NodeIt& operator++() {
+                this->_id = this->_id + 1 < _num ? this->_id + 1 : -1;
+                return *this;
+            }
+        };
+        class ArcIt : public Arc {
+            int _num;
+        public:
+            ArcIt() {}
+            ArcIt(Invalid) : Arc(INVALID), _num(0) {}
+            explicit ArcIt(const MappedDigraph& digraph)
+                : Arc(digraph._arc_num > 0 ? 0 : -1), _num(digraph._arc_num) {}
+            ArcIt(const MappedDigraph& digraph, const Arc& arc)
+                : Arc(arc), _num(digraph._arc_num) {}
+            ArcIt& operator++() {
+                this->_id = this->_id + 1 < _num ? this->_id + 1 : -1;
+                return *this;
+            }
+        };
+        class OutArcIt : public Arc {
+            int _end;
+        public:
+            OutArcIt() {}
+            OutArcIt(Invalid) : Arc(INVALID), _end(0) {}
+            OutArcIt(const MappedDigraph& digraph, const Node& node)
+                : Arc(-1), _end(digraph._out_first[MappedDigraph::id(node) + 1]) {
+                int first = digraph._out_first[MappedDigraph::id(node)];
+                this->_id = first < _end ? first : -1;
+            }
+            OutArcIt(const MappedDigraph& digraph, const Arc& arc)
+                : Arc(arc), _end(digraph._out_first[digraph._arc_source[MappedDigraph::id(arc)] + 1]) {}
+            OutArcIt& operator++() {
+                this->_id = this->_id + 1 < _end ? this->_id + 1 : -1;
+                return *this;
+            }
+        };
+        class InArcIt : public Arc {
+            const std::int32_t* _pos;
+            const std::int32_t* _end;
+        public:
+            InArcIt() {}
+            InArcIt(Invalid) : Arc(INVALID), _pos(0), _end(0) {}
+            InArcIt(const MappedDigraph& digraph, const Node& node)
+                : Arc(-1), _pos(digraph._in_arc + digraph._in_first[MappedDigraph::id(node)]),
+                _end(digraph._in_arc + digraph._in_first[MappedDigraph::id(node) + 1]) {
+                this->_id = _pos != _end ? *_pos : -1;
+            }
+            InArcIt& operator++() {
+                ++_pos;
+                this->_id = _pos != _end ? *_pos : -1;
+                return *this;
+            }
+        };
+
+        template <typename K, typename V>
+        class VectorMap {
+            std::vector<V> _data;
+        public:
+            typedef K Key;
+            typedef V Value;
+            typedef typename std::vector<V>::reference Reference;
+            typedef typename std::vector<V>::const_reference ConstReference;
+            VectorMap(int size, const V& value) : _data(size, value) {}
+            Reference operator[](const K& key) { return _data[MappedDigraph::id(key)]; }
+            ConstReference operator[](const K& key) const { return _data[MappedDigraph::id(key)]; }
+            void set(const K& key, const V& value) { _data[MappedDigraph::id(key)] = value; }
+        };
+        template <typename V>
+        class NodeMap : public VectorMap<Node, V> {
+        public:
+            explicit NodeMap(const MappedDigraph& digraph, const V& value = V())
+                : VectorMap<Node, V>(digraph._node_num, value) {}
+        };
+        template <typename V>
+        class ArcMap : public VectorMap<Arc, V> {
+        public:
+            explicit ArcMap(const MappedDigraph& digraph, const V& value = V())
+                : VectorMap<Arc, V>(digraph._arc_num, value) {}
+        };
+        // read-only arc map on the capacities stored in the file, V must be
+        // the capacity type the file was written with
+        template <typename V>
+        class CapacityMap {
+            const V* _data;
+        public:
+            typedef Arc Key;
+            typedef V Value;
+            typedef const V& ConstReference;
+            explicit CapacityMap(const MappedDigraph& digraph) {
+                if (digraph._header->value_type != BinaryValueType<V>::code)
+                    throw FormatError("Capacity type differs from the binary graph file");
+                _data = reinterpret_cast<const V*>(digraph._data +
+                    _binary_bits::capacityOffset(digraph._node_num, digraph._arc_num));
+            }
+            const V& operator[](const Arc& arc) const { return _data[MappedDigraph::id(arc)]; }
+        };
+
+    private:
+        const char* _data;
+        std::size_t _size;
+#ifdef _WIN32
+        HANDLE _file;
+        HANDLE _mapping;
+#endif
+        const BinaryGraphHeader* _header;
+        int _node_num;
+        int _arc_num;
+        const std::int32_t* _out_first;
+        const std::int32_t* _arc_target;
+        const std::int32_t* _arc_source;
+        const std::int32_t* _in_first;
+        const std::int32_t* _in_arc;
+
+        MappedDigraph(const MappedDigraph&);
+        MappedDigraph& operator=(const MappedDigraph&);
+
+        void map(const std::string& filename) {
+#ifdef _WIN32
+            _file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (_file == INVALID_HANDLE_VALUE)
+                throw IoError("Cannot open file", filename);
+            LARGE_INTEGER size;
+            GetFileSizeEx(_file, &size);
+            _size = std::size_t(size.QuadPart);
+            _mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (_mapping == NULL)
+                throw IoError("Cannot map file", filename);
+            _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (_data == NULL)
+                throw IoError("Cannot map file", filename);
+#else
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw IoError("Cannot open file", filename);
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                ::close(fd);
+                throw IoError("Cannot map file", filename);
+            }
+            _size = std::size_t(st.st_size);
+            void* data = ::mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED)
+                throw IoError("Cannot map file", filename);
+            _data = static_cast<const char*>(data);
+#endif
+        }
+        // the arrays are read in place, a corrupt file must not send the
+        // iterators outside of them, checked once in O(n + m)
+        void validate(const std::string& filename) const {
+            if (_out_first[0] != 0 || _out_first[_node_num] != _arc_num ||
+                _in_first[0] != 0 || _in_first[_node_num] != _arc_num)
+                throw FormatError("Invalid arc index in binary graph file", filename);
+            for (int v = 0; v < _node_num; v++) {
+                if (_out_first[v] > _out_first[v + 1] || _in_first[v] > _in_first[v + 1])
+                    throw FormatError("Invalid arc index in binary graph file", filename);
+                for (int a = _out_first[v]; a < _out_first[v + 1]; a++) {
+                    if (_arc_source[a] != v || _arc_target[a] < 0 || _arc_target[a] >= _node_num)
+                        throw FormatError("Invalid arc end in binary graph file", filename);
+                }
+                for (int k = _in_first[v]; k < _in_first[v + 1]; k++) {
+                    if (_in_arc[k] < 0 || _in_arc[k] >= _arc_num || _arc_target[_in_arc[k]] != v)
+                        throw FormatError("Invalid incoming arc in binary graph file", filename);
+                }
+            }
+        }
+        void unmap() {
+#ifdef _WIN32
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+#else
+            if (_data)
+                ::munmap(const_cast<char*>(_data), _size);
+#endif
+        }
+
+    public:
+        explicit MappedDigraph(const std::string& filename) : _data(NULL), _size(0) {
+#ifdef _WIN32
+            _file = INVALID_HANDLE_VALUE;
+            _mapping = NULL;
+#endif
+            try {
+                map(filename);
+                if (_size < sizeof(BinaryGraphHeader))
+                    throw FormatError("Truncated binary graph file", filename);
+                _header = reinterpret_cast<const BinaryGraphHeader*>(_data);
+                if (std::memcmp(_header->magic, BINARY_GRAPH_MAGIC, sizeof(BINARY_GRAPH_MAGIC)) != 0)
+                    throw FormatError("Not a binary graph file", filename);
+                if (_header->version != BINARY_GRAPH_VERSION)
+                    throw FormatError("Unsupported binary graph file version", filename);
+                const std::int64_t int_max = std::numeric_limits<int>::max();
+                if (_header->node_num < 0 || _header->node_num > int_max ||
+                    _header->arc_num < 0 || _header->arc_num > int_max)
+                    throw FormatError("Invalid node or arc count in binary graph file", filename);
+                if (_header->source < 0 || _header->source >= _header->node_num ||
+                    _header->target < 0 || _header->target >= _header->node_num)
+                    throw FormatError("Invalid source or target in binary graph file", filename);
+                _node_num = int(_header->node_num);
+                _arc_num = int(_header->arc_num);
+                std::size_t value_size = _header->value_type == BinaryValueType<std::int32_t>::code ? 4 : 8;
+                if (_size < _binary_bits::capacityOffset(_node_num, _arc_num) + value_size * _arc_num)
+                    throw FormatError("Truncated binary graph file", filename);
+                const std::int32_t* p = reinterpret_cast<const std::int32_t*>(_data + sizeof(BinaryGraphHeader));
+                _out_first = p;
+                _arc_target = _out_first + _node_num + 1;
+                _arc_source = _arc_target + _arc_num;
+                _in_first = _arc_source + _arc_num;
+                _in_arc = _in_first + _node_num + 1;
+                validate(filename);
+            }
+            catch (...) {
+                unmap();
+                throw;
+            }
+        }
+        ~MappedDigraph() {
+            unmap();
+        }
+
+        // BinaryValueType code of the stored capacities
+        std::uint32_t valueType() const { return _header->value_type; }
+
+        Node source() const { return Node(int(_header->source)); }
+        Node target() const { return Node(int(_header->target)); }
+
+        Node source(const Arc& arc) const { return Node(_arc_source[arc._id]); }
+        Node target(const Arc& arc) const { return Node(_arc_target[arc._id]); }
+        Node oppositeNode(const Node& node, const Arc& arc) const {
+            return _arc_source[arc._id] == node._id ? target(arc) : source(arc);
+        }
+
+        int nodeNum() const { return _node_num; }
+        int arcNum() const { return _arc_num; }
+        int maxNodeId() const { return _node_num - 1; }
+        int maxArcId() const { return _arc_num - 1; }
+        static int id(const Node& node) { return node._id; }
+        static int id(const Arc& arc) { return arc._id; }
+        static Node nodeFromId(int id) { return Node(id); }
+        static Arc arcFromId(int id) { return Arc(id); }
+        bool valid(const Node& node) const { return node._id >= 0 && node._id < _node_num; }
+        bool valid(const Arc& arc) const { return arc._id >= 0 && arc._id < _arc_num; }
+    };
+}
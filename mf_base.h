@@ -1,20 +1,34 @@
 #pragma once
 #include <lemon/core.h>
 #include <lemon/tolerance.h>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <atomic>
+#include <chrono>
 #ifdef INTERRUPT
 #include "InterruptibleThread/InterruptibleThread.h"
 #endif
 #ifdef OPENMP
 #include <omp.h>
 #endif
+#include "preflow_statistics.h"
+#include "node_state.h"
+#include "preflow_arena.h"
 #include "relabel_to_front_elevator.h"
 #include "fifo_elevator.h"
 #include "highest_label_elevator.h"
 #include "parallel_elavator.h"
+#include "async_elevator.h"
+#include "residual_graph.h"
+#include "parallel_bfs.h"
 
 namespace lemon{
 
-    template <typename GR, typename CAP>
+    // NS is the layout of the label, excess and current arc of the nodes,
+    // PackedNodeState (AoS) or SplitNodeState (SoA)
+    template <typename GR, typename CAP,
+              typename NS = PackedNodeState<typename CAP::Value> >
     struct Preflow_RelabelDefaultTraits {
         typedef GR Digraph;
         typedef CAP CapacityMap;
@@ -23,13 +37,16 @@ namespace lemon{
         static FlowMap* createFlowMap(const Digraph& digraph) {
             return new FlowMap(digraph);
         }
-        typedef RelabelElevator<Digraph, typename Digraph::Node> Elevator;
+        typedef NS NodeState;
+        typedef RelabelElevator<Digraph, typename Digraph::Node, NodeState> Elevator;
         static Elevator* createElevator(const Digraph& digraph, int max_level) {
             return new Elevator(digraph, max_level);
         }
         typedef lemon::Tolerance<Value> Tolerance;
+        typedef NoPreflowStatistics Statistics;
     };
-	template <typename GR, typename CAP>
+	template <typename GR, typename CAP,
+		typename NS = PackedNodeState<typename CAP::Value> >
 	struct Preflow_FIFODefaultTraits {
 		typedef GR Digraph;
 		typedef CAP CapacityMap;
@@ -38,13 +55,16 @@ namespace lemon{
 		static FlowMap* createFlowMap(const Digraph& digraph) {
 			return new FlowMap(digraph);
 		}
-		typedef FIFOElevator<Digraph, typename Digraph::Node> Elevator;
+		typedef NS NodeState;
+		typedef FIFOElevator<Digraph, typename Digraph::Node, NodeState> Elevator;
 		static Elevator* createElevator(const Digraph& digraph, int max_level) {
 			return new Elevator(digraph, max_level);
 		}
 		typedef lemon::Tolerance<Value> Tolerance;
+		typedef NoPreflowStatistics Statistics;
 	};
-    template <typename GR, typename CAP>
+    template <typename GR, typename CAP,
+              typename NS = PackedNodeState<typename CAP::Value> >
     struct Preflow_HLDefaultTraits {
         typedef GR Digraph;
         typedef CAP CapacityMap;
@@ -53,11 +73,13 @@ namespace lemon{
         static FlowMap* createFlowMap(const Digraph& digraph) {
             return new FlowMap(digraph);
         }
-        typedef HLElevator<Digraph, typename Digraph::Node> Elevator;
+        typedef NS NodeState;
+        typedef HLElevator<Digraph, typename Digraph::Node, NodeState> Elevator;
         static Elevator* createElevator(const Digraph& digraph, int max_level) {
             return new Elevator(digraph, max_level);
         }
         typedef lemon::Tolerance<Value> Tolerance;
+        typedef NoPreflowStatistics Statistics;
     };
     template <typename GR,
               typename CAP,
@@ -73,7 +95,13 @@ namespace lemon{
             typedef typename Traits::FlowMap FlowMap;
             typedef typename Traits::Tolerance Tolerance; 
             typedef typename Traits::Elevator Elevator;
-            typedef typename Digraph::template NodeMap<Value> ExcessMap;
+            typedef typename Traits::Statistics Statistics;
+            typedef typename Elevator::NodeState NodeState;
+            typedef lemon::ResidualGraph<Digraph, Value> ResidualGraph;
+            typedef std::chrono::steady_clock::time_point TimePoint;
+            // result of a run or a phase, an interrupted one leaves a valid
+            // preflow behind and can be resumed by calling the phase again
+            enum Status { COMPLETED, INTERRUPTED };
         private:  
             TEMPLATE_DIGRAPH_TYPEDEFS(Digraph);
             
@@ -81,151 +109,483 @@ namespace lemon{
             int _node_num;            
          
 			bool is_local_elevator = true;
-            //! minimum source side cut
-            BoolNodeMap _source_side; 
-			//! minimum sink side cut
-			BoolNodeMap _sink_side;
+            //! minimum source side cut, indexed by node id
+            std::vector<char> _source_side;
+			//! minimum sink side cut, indexed by node id
+			std::vector<char> _sink_side;
 
 		protected:
-            const Digraph& _graph;
+            const Digraph* _graph;
             const CapacityMap* _capacity;
-            ExcessMap* _excess;
-            FlowMap* _flow;
+            // created by the first flowMap() call
+            mutable FlowMap* _flow;
             Tolerance _tolerance;
 			Elevator* _elevator;
+			// label, excess and residual arc each node resumes its scan from
+			// (reset on relabel), kept by the elevator
+			NodeState* _nodes;
 			Node _source, _target;
+			// residual graph the solver works on, _flow is only filled from it on request
+			ResidualGraph _res;
+			ParallelBfs<ResidualGraph, Tolerance> _bfs;
+			// global relabel is run once _relabel_work * _global_relabel_freq
+			// exceeds ALPHA * n + m, 0 disables it
+			double _global_relabel_freq;
+			long long _relabel_work;
+			static const int ALPHA = 6;
+			static const int BETA = 12;
+			// scratch space of the label searches, returnExcess() and
+			// updateCapacities(), _own_arena unless shared by arena()
+			PreflowArena _own_arena;
+			PreflowArena* _arena;
+			// operation counters, free with NoPreflowStatistics
+			Statistics _stats;
+			// integral capacities (int32, int64) use plain comparisons and a
+			// branch free push in the hot loops, floating point ones the Tolerance
+			static const bool INTEGRAL = std::numeric_limits<Value>::is_integer;
+			bool positive(Value v) const {
+				return INTEGRAL ? v > 0 : _tolerance.positive(v);
+			}
+			bool less(Value a, Value b) const {
+				return INTEGRAL ? a < b : _tolerance.less(a, b);
+			}
+			// cancellation, checked once every _check_interval discharges
+			const std::atomic<bool>* _stop_token;
+			TimePoint _deadline;
+			int _check_interval;
+			int _check_countdown;
+			Status _status;
+			// residual arcs and nodes whose residual capacity or excess
+			// updateCapacities() changed, recorded with _track_changes for a
+			// solver keeping its own copy of them (Preflow_Async), which
+			// copies all of them after _all_changed is set by a rewrite
+			bool _track_changes;
+			bool _all_changed;
+			std::vector<int> _changed_arcs;
+			std::vector<int> _changed_nodes;
 
 		private:
-            void createStructures() {
-                _node_num = countNodes(_graph);
-                if(!_flow){
-                    _flow = Traits::createFlowMap(_graph);                   
+            // exact labels by a backward breadth-first search over the residual
+            // graph from the target, with source_side the nodes cut off from the
+            // target are searched from the source at maxLevel() as well, else the
+            // source is left out. _reached tells the nodes found afterwards.
+            void exactLabels(bool source_side) {
+                std::vector<char>& _reached = _arena->reached;
+                std::vector<int>& _queue = _arena->queue;
+                int max_level = _elevator->maxLevel();
+                _reached.assign(_res.nodeNum(), 0);
+                _elevator->initStart();
+                int level = 0;
+                if (!source_side)
+                    _reached[_graph->id(_source)] = 1;
+                Node roots[2] = { _target, _source };
+                for (int r = 0; r < (source_side ? 2 : 1); r++) {
+                    // the source starts at level n
+                    for (; r == 1 && level < max_level; level++)
+                        _elevator->initNewLevel();
+                    int root = _graph->id(roots[r]);
+                    _reached[root] = 1;
+                    _elevator->initAddItem(roots[r]);
+                    _queue.assign(1, root);
+                    for (int head = 0; head < int(_queue.size());) {
+                        _elevator->initNewLevel();
+                        level++;
+                        int end = int(_queue.size());
+                        for (; head < end; head++) {
+                            int n = _queue[head];
+                            for (int a = _res.outBegin(n); a != _res.outEnd(n); ++a) {
+                                int u = _res.target(a);
+                                if (!_reached[u] && _tolerance.positive(_res.residual(_res.pair(a)))) {
+                                    _reached[u] = 1;
+                                    _elevator->initAddItem(_graph->nodeFromId(u));
+                                    _queue.push_back(u);
+                                }
+                            }
+                        }
+                    }
                 }
+                _elevator->initFinish();
+            }
+            void activateExcess(int i) {
+                Node n = _graph->nodeFromId(i);
+                if (n != _source && n != _target && !_elevator->active(n) &&
+                    _tolerance.positive(_nodes->excess(i)))
+                    _elevator->activate(n);
+            }
+            void createStructures() {
+                _node_num = countNodes(*_graph);
                 if(!_elevator){
-                    _elevator = Traits::createElevator(_graph, _node_num);
+                    _elevator = Traits::createElevator(*_graph, _node_num);
                 }
-                if(!_excess){
-                    _excess = new ExcessMap(_graph);
+                if(!_res.built()){
+                    _res.build(*_graph);
                 }
+                _nodes = &_elevator->nodeState();
+                resetCurrentArcs();
             }
             
             void destroyStructures() {
                 delete _flow;
 				if(is_local_elevator)
 	                delete _elevator;
-                delete _excess;
             }
-            // push flow from Node u to Node v
-            inline void push(const Node& u, const Node& v, const Arc& e) {
-#ifdef INTERRUPT
-                InterruptibleThread::interruption_point();
-#endif
+            // push flow from Node u to Node v along the residual arc a
+            inline void push(const Node& u, const Node& v, int a) {
                 if(!_elevator->active(v) && v != _target && v != _source){
                     _elevator->activate(v);
                 }
-                Value rem = (*_capacity)[e] - (*_flow)[e];
-                Value excess = (*_excess)[u];
+                Value rem = _res.residual(a);
+                Value& excess = _nodes->excess(_graph->id(u));
+                Value& head_excess = _nodes->excess(_graph->id(v));
+                if (INTEGRAL) {
+                    Value delta = rem < excess ? rem : excess;
+                    _stats.push(rem < excess, !_res.forward(a));
+                    excess -= delta;
+                    head_excess += delta;
+                    _res.augment(a, delta);
+                    return;
+                }
                 if(_tolerance.less(rem, excess)){ // rem + epsilon < excess
 					// saturating push
-					(*_excess)[u] -= rem;
-					(*_excess)[v] += rem;
-					_flow->set(e, (*_capacity)[e]);
+					excess -= rem;
+					head_excess += rem;
+					_res.augment(a, rem);
+					_stats.push(true, !_res.forward(a));
                 }
                 else {
 					// non-saturating push
-					(*_excess)[u] = 0;
-					(*_excess)[v] += excess;
-					_flow->set(e, (*_flow)[e] + excess);
+					head_excess += excess;
+					_res.augment(a, excess);
+					excess = 0;
+					_stats.push(false, !_res.forward(a));
                 }
             }
-            // push flow back from Node u to Node v
-            inline void push_back(const Node& u, const Node& v, const Arc& e) {
-#ifdef INTERRUPT
-                InterruptibleThread::interruption_point();
-#endif
-                if(!_elevator->active(v) && v != _source && v != _target){
-                    _elevator->activate(v);
-                }
-                Value rem = (*_flow)[e];
-                Value excess = (*_excess)[u];
-                if(_tolerance.less(rem, excess)){
-                    // saturating push
-                    (*_excess)[u] -= rem;
-                    (*_excess)[v] += rem;
-                    _flow->set(e, 0);
-                }
-                else {
-                    // no saturating push
-                    (*_excess)[u] = 0;
-                    (*_excess)[v] += excess;
-                    _flow->set(e, (*_flow)[e] - excess);
-                }                
-            }
             inline void relabel(const Node& n, int new_level) {
                 _elevator->lift(n, new_level + 1);
+                _stats.relabel();
+            }
+            // saturate the residual arcs leaving the source, used by warm start
+            void saturateSourceArcs() {
+                int s = _graph->id(_source);
+                for (int a = _res.outBegin(s); a != _res.outEnd(s); ++a) {
+                    Value rem = _res.residual(a);
+                    if (_tolerance.positive(rem)) {
+                        Node u = _graph->nodeFromId(_res.target(a));
+                        if ((*_elevator)[u] == _elevator->maxLevel()) continue;
+                        _res.augment(a, rem);
+                        _nodes->excess(_graph->id(u)) += rem;
+                    }
+                }
             }
 		protected:
+			void resetCurrentArcs() {
+				for (int i = 0; i < _res.nodeNum(); i++)
+					_nodes->current(i) = _res.outBegin(i);
+			}
+			// lowest label among the heads of the residual arcs leaving node i,
+			// 2 * maxLevel() if there is none
+			int minResidualLevel(int i) const {
+				int new_level = 2 * _elevator->maxLevel();
+				for (int a = _res.outBegin(i); a != _res.outEnd(i); ++a) {
+					if (positive(_res.residual(a))) {
+						int level = _nodes->level(_res.target(a));
+						if (new_level > level)
+							new_level = level;
+					}
+				}
+				return new_level;
+			}
 			void discharge(const Node& n) {
-                while(_tolerance.positive((*_excess)[n])){
-                    int new_level = 2 * _elevator->maxLevel();
-                    for(OutArcIt e(_graph, n); e != INVALID; ++e){
-                        Node v = _graph.target(e);
-                        if (_tolerance.positive((*_capacity)[e] - (*_flow)[e])){
-                            if((*_elevator)[n] == (*_elevator)[v] + 1){
-                                push(n, v, e);
+                int i = _graph->id(n);
+                int& cur = _nodes->current(i);
+                Value& excess = _nodes->excess(i);
+                _stats.discharge();
+                while(positive(excess)){
+                    for(; cur != _res.outEnd(i); ++cur){
+                        if (positive(_res.residual(cur))){
+                            int j = _res.target(cur);
+                            if(_nodes->level(i) == _nodes->level(j) + 1){
+                                push(n, _graph->nodeFromId(j), cur);
+								if (excess == 0)
+									break;
                             }
-							else if (new_level > (*_elevator)[v]) {
-								new_level = (*_elevator)[v];
-							}
-							if ((*_excess)[n] == 0)
-								break;
-                        }
-                    }
-					if ((*_excess)[n] == 0)
-						break;
-                    for(InArcIt e(_graph, n); e != INVALID; ++e) {
-                        Node v = _graph.source(e);
-
-                        if (_tolerance.positive((*_flow)[e])){
-                            if((*_elevator)[n] == (*_elevator)[v] + 1) {
-                                push_back(n, v, e); // push back the flow
-                            }
-							else if (new_level > (*_elevator)[v]) {
-								new_level = (*_elevator)[v];
-							}
-							if ((*_excess)[n] == 0)
-								break;                            
                         }
                     }
-					if ((*_excess)[n] == 0)
+					if (excess == 0)
 						break;
+					_relabel_work += BETA + _res.outEnd(i) - _res.outBegin(i);
+					int new_level = minResidualLevel(i);
+					cur = _res.outBegin(i);
+					// a label changed behind the current arc (gap, warm start), rescan
+					if (new_level + 1 == (*_elevator)[n])
+						continue;
 					if (new_level + 1 < 2 * _elevator->maxLevel())
 						relabel(n, new_level);
 					else{
 						// lift to maximal, no other node can push (or pushback to Node n)
 						_elevator->lift(n, 2 * _elevator->maxLevel() - 1);
+						_stats.relabel();
 						break;
 					}
                 }
-				(*_excess)[n] = 0;
+				excess = 0;
                 _elevator->deactivate(n);
             }
+            // flow on the forward residual arc a
+            Value arcFlow(int a) const {
+                return _res.residual(_res.pair(a));
+            }
+            // turn the maximum preflow left by the first phase into a flow
+            // without another push-relabel pass (as in HIPR). Only the nodes
+            // cut off from the target hold excess, and it goes back along flow
+            // carrying arcs between them. A depth-first search over these arcs
+            // cancels the flow cycles it meets, so it yields a topological
+            // order, and every node in reverse topological order sends its
+            // excess back along its incoming flow. Returns false, doing
+            // nothing, if a node with excess can still reach the target.
+            bool returnExcess() {
+                _all_changed = true;
+                get_min_sink_side();
+                int s = _graph->id(_source);
+                int node_num = _res.nodeNum();
+                for (NodeIt n(*_graph); n != INVALID; ++n) {
+                    int i = _graph->id(n);
+                    if (_sink_side[i] && n != _source && n != _target && _tolerance.positive(_nodes->excess(i)))
+                        return false;
+                }
+                std::vector<char>& _reached = _arena->reached;
+                std::vector<int>& _queue = _arena->queue;
+                std::vector<int>& _stack = _arena->stack;
+                std::vector<int>& _dfs_arc = _arena->dfs_arc;
+                // 0 unvisited, 1 on the stack, 2 finished
+                _reached.assign(node_num, 0);
+                _dfs_arc.resize(node_num);
+                for (int i = 0; i < node_num; i++)
+                    _dfs_arc[i] = _res.outBegin(i);
+                _queue.clear();
+                for (int r = 0; r < node_num; r++) {
+                    if (r == s || _sink_side[r] || _reached[r])
+                        continue;
+                    _reached[r] = 1;
+                    _stack.assign(1, r);
+                    while (!_stack.empty()) {
+                        int u = _stack.back();
+                        int& a = _dfs_arc[u];
+                        int v = -1;
+                        for (; a != _res.outEnd(u); ++a) {
+                            if (!_res.forward(a) || !_tolerance.positive(arcFlow(a)))
+                                continue;
+                            v = _res.target(a);
+                            if (v != s && !_sink_side[v] && _reached[v] != 2)
+                                break;
+                        }
+                        if (a == _res.outEnd(u)) {
+                            _reached[u] = 2;
+                            _queue.push_back(u);
+                            _stack.pop_back();
+                            continue;
+                        }
+                        if (_reached[v] == 0) {
+                            _reached[v] = 1;
+                            _stack.push_back(v);
+                            continue;
+                        }
+                        // v is on the stack, cancel the cycle from v to u and back
+                        int k = int(_stack.size()) - 1;
+                        while (_stack[k] != v)
+                            k--;
+                        Value delta = arcFlow(a);
+                        for (int j = k; j < int(_stack.size()); j++) {
+                            Value f = arcFlow(_dfs_arc[_stack[j]]);
+                            if (f < delta)
+                                delta = f;
+                        }
+                        for (int j = k; j < int(_stack.size()); j++)
+                            _res.augment(_res.pair(_dfs_arc[_stack[j]]), delta);
+                        // continue from the first node whose arc ran dry
+                        for (int j = k; j < int(_stack.size()); j++) {
+                            if (!_tolerance.positive(arcFlow(_dfs_arc[_stack[j]]))) {
+                                for (int l = j + 1; l < int(_stack.size()); l++)
+                                    _reached[_stack[l]] = 0;
+                                _stack.resize(j + 1);
+                                break;
+                            }
+                        }
+                    }
+                }
+                // a node finishes after all nodes it sends flow to
+                for (int i : _queue) {
+                    Node n = _graph->nodeFromId(i);
+                    Value& excess = _nodes->excess(i);
+                    for (int b = _res.outBegin(i); b != _res.outEnd(i) && _tolerance.positive(excess); ++b) {
+                        Value rem = _res.residual(b);
+                        if (_res.forward(b) || !_tolerance.positive(rem))
+                            continue;
+                        Value d = rem < excess ? rem : excess;
+                        _res.augment(b, d);
+                        excess -= d;
+                        _nodes->excess(_res.target(b)) += d;
+                    }
+                    // only rounding errors are left
+                    excess = 0;
+                    if (_elevator->active(n))
+                        _elevator->deactivate(n);
+                }
+                return true;
+            }
+            // stop token set or deadline passed, safe to call from any thread
+            bool cancelRequested() const {
+                return (_stop_token && _stop_token->load(std::memory_order_relaxed)) ||
+                    (_deadline != TimePoint::max() && std::chrono::steady_clock::now() >= _deadline);
+            }
+            // count discharges done, every _check_interval of them the
+            // cancellation is checked and the phase is marked interrupted
+            bool cancelled(int discharges = 1) {
+                _check_countdown -= discharges;
+                if (_check_countdown > 0)
+                    return false;
+                _check_countdown = _check_interval;
+#ifdef INTERRUPT
+                InterruptibleThread::interruption_point();
+#endif
+                if (cancelRequested())
+                    _status = INTERRUPTED;
+                return _status == INTERRUPTED;
+            }
+            // the cancellation is checked before the first discharge of a phase
+            void beginPhase() {
+                _status = COMPLETED;
+                _check_countdown = 0;
+            }
+            bool globalRelabelDue() const {
+                return _global_relabel_freq > 0 &&
+                    _relabel_work * _global_relabel_freq > ALPHA * _node_num + _res.arcNum() / 2;
+            }
+            // recompute exact distance labels by a backward breadth-first search
+            // over the residual graph, from the target first, then from the source
+            // for the nodes cut off from the target, and rebuild the active set
+            void globalRelabel() {
+                _relabel_work = 0;
+                _stats.globalRelabel();
+                int max_level = _elevator->maxLevel();
+                exactLabels(true);
+                resetCurrentArcs();
+                for (NodeIt n(*_graph); n != INVALID; ++n) {
+                    if (!_arena->reached[_graph->id(n)])
+                        _elevator->lift(n, 2 * max_level - 1);
+                    else if (n != _source && n != _target && _tolerance.positive(_nodes->excess(_graph->id(n))))
+                        _elevator->activate(n);
+                }
+            }
             
         public:     
             Preflow_Base(const Digraph& digraph, const CapacityMap& capacity, 
                             Node source, Node target)
-                : _graph(digraph), _capacity(&capacity),
+                : _graph(&digraph), _capacity(&capacity),
                   _node_num(0), _source(source), _target(target),
-                  _flow(NULL), _elevator(NULL), _excess(NULL),
-                  _tolerance(), _source_side(digraph), _sink_side(digraph){}
+                  _flow(NULL), _elevator(NULL), _nodes(NULL),
+                  _tolerance(),
+                  _global_relabel_freq(0), _relabel_work(0), _arena(&_own_arena),
+                  _stop_token(NULL), _deadline(TimePoint::max()),
+                  _check_interval(256), _check_countdown(0), _status(COMPLETED),
+                  _track_changes(false), _all_changed(true){}
             
             ~Preflow_Base(){
                 destroyStructures();
             }
 			virtual void pushRelabel(bool limit_max_level) = 0;
+			// cooperative cancellation: the phases stop with status() INTERRUPTED
+			// once the token is set or the deadline has passed. NULL and
+			// TimePoint::max() disable them.
+			Preflow_Base& stopToken(const std::atomic<bool>* token) {
+				_stop_token = token;
+				return *this;
+			}
+			Preflow_Base& deadline(TimePoint time) {
+				_deadline = time;
+				return *this;
+			}
+			// number of discharges between two cancellation checks
+			Preflow_Base& checkInterval(int discharges) {
+				_check_interval = discharges < 1 ? 1 : discharges;
+				return *this;
+			}
+			Status status() const {
+				return _status;
+			}
+			// enable the global relabel heuristic, a typical frequency is 0.5
+			void globalRelabelFrequency(double freq) {
+				_global_relabel_freq = freq;
+			}
+			// change the source or the target, the next init() starts from the
+			// new terminals and reuses all allocated structures
+			Preflow_Base& source(const Node& node) {
+				_source = node;
+				return *this;
+			}
+			Preflow_Base& target(const Node& node) {
+				_target = node;
+				return *this;
+			}
+			// solve another instance with this solver: the digraph, the
+			// capacities and the terminals are replaced, the elevator, the
+			// residual graph and the scratch space keep their memory where it
+			// suffices. The next init() or run() solves the new instance, an
+			// elevator given to init(flowMap, ele) is not used any more.
+			Preflow_Base& reset(const Digraph& digraph, const CapacityMap& capacity,
+				Node source, Node target) {
+				if (&digraph != _graph) {
+					// a flow map is bound to its digraph
+					delete _flow;
+					_flow = NULL;
+				}
+				_graph = &digraph;
+				_capacity = &capacity;
+				_source = source;
+				_target = target;
+				_node_num = countNodes(digraph);
+				if (!is_local_elevator) {
+					_elevator = NULL;
+					is_local_elevator = true;
+				}
+				if (_elevator)
+					_elevator->reset(digraph, _node_num);
+				_res.build(digraph);
+				_all_changed = true;
+				return *this;
+			}
+			// scratch space shared with other solvers, which must not run at
+			// the same time, the arena has to outlive this solver
+			Preflow_Base& arena(PreflowArena& scratch) {
+				_arena = &scratch;
+				return *this;
+			}
+			const ResidualGraph& residualGraph() const {
+				return _res;
+			}
+			// run on the arc structure of res, built by another solver of the
+			// same digraph, instead of building an own copy in init()
+			void shareResidualGraph(const ResidualGraph& res) {
+				_res.share(res);
+				_all_changed = true;
+			}
+			// the flow map is filled from the residual graph on each call
 			const FlowMap& flowMap() const {
+				if (!_flow)
+					_flow = Traits::createFlowMap(*_graph);
+				for (ArcIt e(*_graph); e != INVALID; ++e) {
+					_flow->set(e, _res.flow(_graph->id(e)));
+				}
 				return *_flow;
 			}
+			Value flow(const Arc& arc) const {
+				return _res.flow(_graph->id(arc));
+			}
+			// operation counts since the last init(), all zero unless the
+			// traits select PreflowStatistics
+			PreflowCounters statistics() const {
+				return _stats.counters();
+			}
 			Elevator* elevator() {
 				if (is_local_elevator)
 					return new Elevator(*_elevator);
@@ -233,105 +593,161 @@ namespace lemon{
 			}
             // after capacity change, reinit the class, used by parametric maximal flow
             void reinit() {
-                // update _flow, _excess connected with sink_node
-                for (InArcIt e(_graph, _target); e != INVALID; ++e) {
-                    if ((*_flow)[e] > (*_capacity)[e]) {
-                        Node v = _graph.source(e);
-                        (*_excess)[v] += ((*_flow)[e] - (*_capacity)[e]);
-                        _flow->set(e, (*_capacity)[e]);
+                _all_changed = true;
+                // update _flow, the excess connected with sink_node
+                for (InArcIt e(*_graph, _target); e != INVALID; ++e) {
+                    int id = _graph->id(e);
+                    Value flow = _res.flow(id);
+                    if (flow > (*_capacity)[e]) {
+                        Node v = _graph->source(e);
+                        _nodes->excess(_graph->id(v)) += (flow - (*_capacity)[e]);
+                        _res.setArc(id, (*_capacity)[e], (*_capacity)[e]);
                         _elevator->activate(v);
                     }
+                    else {
+                        _res.setArc(id, (*_capacity)[e], flow);
+                    }
                 }
-                // update _flow, _excess connected with source_node
-                for (OutArcIt e(_graph, _source); e != INVALID; ++e) {
-                    if ((*_capacity)[e] > (*_flow)[e]) {
-                        Node u = _graph.target(e);
-                        // can we do not distinguish _level->maxLevel() ?
-                        if (u != _target && (*_elevator)[u] <= 1 + _elevator->maxLevel()) {
-                            (*_excess)[u] += ((*_capacity)[e] - (*_flow)[e]);
-                            _flow->set(e, (*_capacity)[e]);
-                            _elevator->activate(u);
-                        }
+                // update _flow, the excess connected with source_node
+                for (OutArcIt e(*_graph, _source); e != INVALID; ++e) {
+                    int id = _graph->id(e);
+                    Value flow = _res.flow(id);
+                    Node u = _graph->target(e);
+                    // can we do not distinguish _level->maxLevel() ?
+                    if ((*_capacity)[e] > flow && u != _target &&
+                        (*_elevator)[u] <= 1 + _elevator->maxLevel()) {
+                        _nodes->excess(_graph->id(u)) += ((*_capacity)[e] - flow);
+                        _res.setArc(id, (*_capacity)[e], (*_capacity)[e]);
+                        _elevator->activate(u);
+                    }
+                    else {
+                        _res.setArc(id, (*_capacity)[e], flow);
                     }
                 }
             }
-			bool init(const FlowMap& flowMap) {
-				createStructures();
-
-				for (ArcIt e(_graph); e != INVALID; ++e) {
-					_flow->set(e, flowMap[e]);
+			// set new capacities on a batch of arcs of a solved or partly solved
+			// instance, then resume with startFirstPhase() and startSecondPhase().
+			// Flow above the new capacity goes back to the tail as excess, the
+			// missing inflow at the head is cancelled forward along flow carrying
+			// arcs, and labels made invalid by new residual arcs are lowered. Only
+			// the nodes reached this way are touched. The capacity map given to
+			// the constructor is not read, keep it in sync for a later init().
+			void updateCapacities(const std::vector<std::pair<Arc, Value> >& changes) {
+				int s = _graph->id(_source);
+				int t = _graph->id(_target);
+				std::vector<std::pair<int, int> >& _update_arcs = _arena->update_arcs;
+				std::vector<int>& _deficit_nodes = _arena->deficit_nodes;
+				_update_arcs.clear();
+				_deficit_nodes.clear();
+				for (const std::pair<Arc, Value>& c : changes) {
+					int id = _graph->id(c.first);
+					int a = _res.forwardArc(id);
+					int u = _graph->id(_graph->source(c.first));
+					int v = _res.target(a);
+					Value flow = _res.flow(id);
+					if (_tolerance.less(c.second, flow)) {
+						Value d = flow - c.second;
+						_nodes->excess(u) += d;
+						_nodes->excess(v) -= d;
+						_res.setArc(id, c.second, c.second);
+						activateExcess(u);
+						if (v != s && v != t && _tolerance.negative(_nodes->excess(v)))
+							_deficit_nodes.push_back(v);
+					}
+					else {
+						_res.setArc(id, c.second, flow);
+						_update_arcs.push_back(std::make_pair(u, a));
+					}
 				}
-
-				for (NodeIt n(_graph); n != INVALID; ++n) {
-					Value excess = 0;
-					for (InArcIt e(_graph, n); e != INVALID; ++e) {
-						excess += (*_flow)[e];
+				// cancel flow leaving a node with a deficit, this moves the
+				// deficit on until it reaches the source or the target
+				while (!_deficit_nodes.empty()) {
+					int u = _deficit_nodes.back();
+					_deficit_nodes.pop_back();
+					Value& excess = _nodes->excess(u);
+					for (int a = _res.outBegin(u); a != _res.outEnd(u) && _tolerance.negative(excess); ++a) {
+						Value flow = _res.residual(_res.pair(a));
+						if (!_res.forward(a) || !_tolerance.positive(flow))
+							continue;
+						Value d = flow < -excess ? flow : -excess;
+						int v = _res.target(a);
+						Value& head_excess = _nodes->excess(v);
+						bool was_negative = _tolerance.negative(head_excess);
+						_res.augment(_res.pair(a), d);
+						excess += d;
+						head_excess -= d;
+						_update_arcs.push_back(std::make_pair(u, a));
+						if (v != s && v != t && !was_negative && _tolerance.negative(head_excess))
+							_deficit_nodes.push_back(v);
 					}
-					for (OutArcIt e(_graph, n); e != INVALID; ++e) {
-						excess -= (*_flow)[e];
+					// only rounding errors are left
+					if (excess < 0)
+						excess = 0;
+				}
+				// a new residual arc from u to v needs level[u] <= level[v] + 1,
+				// u is lowered otherwise, which is checked again for the arcs into u
+				for (int k = 0; k < int(_update_arcs.size()); k++) {
+					int u = _update_arcs[k].first;
+					int a = _update_arcs[k].second;
+					Node un = _graph->nodeFromId(u);
+					Node vn = _graph->nodeFromId(_res.target(a));
+					_nodes->current(u) = _res.outBegin(u);
+					if (!_tolerance.positive(_res.residual(a)) || (*_elevator)[un] <= (*_elevator)[vn] + 1)
+						continue;
+					if (u == s) {
+						// the source keeps its label, saturate the arc instead
+						Value d = _res.residual(a);
+						_res.augment(a, d);
+						_nodes->excess(u) -= d;
+						_nodes->excess(_res.target(a)) += d;
+						activateExcess(_res.target(a));
+						_update_arcs.push_back(std::make_pair(_res.target(a), _res.pair(a)));
+						continue;
 					}
-					if (_tolerance.negative(excess) && n != _source) return false;
-					(*_excess)[n] = excess;
+					_elevator->lift(un, (*_elevator)[vn] + 1);
+					for (int b = _res.outBegin(u); b != _res.outEnd(u); ++b)
+						_update_arcs.push_back(std::make_pair(_res.target(b), _res.pair(b)));
 				}
-
-				typename Digraph::template NodeMap<bool> reached(_graph, false);
-				Elevator* _level = _elevator;
-				_level->initStart();
-				_level->initAddItem(_target);
-
-				std::vector<Node> queue;
-				reached[_source] = true;
-
-				queue.push_back(_target);
-				reached[_target] = true;
-				while (!queue.empty()) {
-					_level->initNewLevel();
-					std::vector<Node> nqueue;
-					for (int i = 0; i < int(queue.size()); ++i) {
-						Node n = queue[i];
-						for (InArcIt e(_graph, n); e != INVALID; ++e) {
-							Node u = _graph.source(e);
-							if (!reached[u] &&
-								_tolerance.positive((*_capacity)[e] - (*_flow)[e])) {
-								reached[u] = true;
-								_level->initAddItem(u);
-								nqueue.push_back(u);
-							}
-						}
-						for (OutArcIt e(_graph, n); e != INVALID; ++e) {
-							Node v = _graph.target(e);
-							if (!reached[v] && _tolerance.positive((*_flow)[e])) {
-								reached[v] = true;
-								_level->initAddItem(v);
-								nqueue.push_back(v);
-							}
-						}
+				if (_track_changes && !_all_changed) {
+					// flow moved along a and its pair, between u and the head of a
+					for (const std::pair<Arc, Value>& c : changes) {
+						int a = _res.forwardArc(_graph->id(c.first));
+						_changed_arcs.push_back(a);
+						_changed_nodes.push_back(_graph->id(_graph->source(c.first)));
+						_changed_nodes.push_back(_res.target(a));
+					}
+					for (const std::pair<int, int>& e : _update_arcs) {
+						_changed_arcs.push_back(e.second);
+						_changed_nodes.push_back(e.first);
+						_changed_nodes.push_back(_res.target(e.second));
 					}
-					queue.swap(nqueue);
 				}
-				_level->initFinish();
+			}
+			bool init(const FlowMap& flowMap) {
+				createStructures();
+				_res.setFlow(*_graph, *_capacity, flowMap);
+				_all_changed = true;
+				_stats.clear();
+				_status = COMPLETED;
 
-				for (OutArcIt e(_graph, _source); e != INVALID; ++e) {
-					Value rem = (*_capacity)[e] - (*_flow)[e];
-					if (_tolerance.positive(rem)) {
-						Node u = _graph.target(e);
-						if ((*_level)[u] == _level->maxLevel()) continue;
-						_flow->set(e, (*_capacity)[e]);
-						(*_excess)[u] += rem;
+				for (NodeIt n(*_graph); n != INVALID; ++n) {
+					Value excess = 0;
+					for (InArcIt e(*_graph, n); e != INVALID; ++e) {
+						excess += flowMap[e];
 					}
-				}
-				for (InArcIt e(_graph, _source); e != INVALID; ++e) {
-					Value rem = (*_flow)[e];
-					if (_tolerance.positive(rem)) {
-						Node v = _graph.source(e);
-						if ((*_level)[v] == _level->maxLevel()) continue;
-						_flow->set(e, 0);
-						(*_excess)[v] += rem;
+					for (OutArcIt e(*_graph, n); e != INVALID; ++e) {
+						excess -= flowMap[e];
 					}
+					if (_tolerance.negative(excess) && n != _source) return false;
+					_nodes->excess(_graph->id(n)) = excess;
 				}
-				for (NodeIt n(_graph); n != INVALID; ++n)
-					if (n != _source && n != _target && _tolerance.positive((*_excess)[n]))
-						_level->activate(n);
+
+				exactLabels(false);
+
+				saturateSourceArcs();
+				for (NodeIt n(*_graph); n != INVALID; ++n)
+					if (n != _source && n != _target && _tolerance.positive(_nodes->excess(_graph->id(n))))
+						_elevator->activate(n);
 
 				return true;
 			}
@@ -339,44 +755,27 @@ namespace lemon{
 				is_local_elevator = false;
 				_elevator = ele; // elevator is not initialized
 				createStructures();
+				_res.setFlow(*_graph, *_capacity, flowMap);
+				_all_changed = true;
+				_stats.clear();
+				_status = COMPLETED;
 
-				for (ArcIt e(_graph); e != INVALID; ++e) {
-					_flow->set(e, flowMap[e]);
-				}
-
-				for (NodeIt n(_graph); n != INVALID; ++n) {
+				for (NodeIt n(*_graph); n != INVALID; ++n) {
 					Value excess = 0;
-					for (InArcIt e(_graph, n); e != INVALID; ++e) {
-						excess += (*_flow)[e];
+					for (InArcIt e(*_graph, n); e != INVALID; ++e) {
+						excess += flowMap[e];
 					}
-					for (OutArcIt e(_graph, n); e != INVALID; ++e) {
-						excess -= (*_flow)[e];
+					for (OutArcIt e(*_graph, n); e != INVALID; ++e) {
+						excess -= flowMap[e];
 					}
 					if (_tolerance.negative(excess) && n != _source) 
 						return false;
-					(*_excess)[n] = excess;
+					_nodes->excess(_graph->id(n)) = excess;
 				}
 
-				for (OutArcIt e(_graph, _source); e != INVALID; ++e) {
-					Value rem = (*_capacity)[e] - (*_flow)[e];
-					if (_tolerance.positive(rem)) {
-						Node u = _graph.target(e);
-						if ((*_elevator)[u] == _elevator->maxLevel()) continue;
-						_flow->set(e, (*_capacity)[e]);
-						(*_excess)[u] += rem;
-					}
-				}
-				for (InArcIt e(_graph, _source); e != INVALID; ++e) {
-					Value rem = (*_flow)[e];
-					if (_tolerance.positive(rem)) {
-						Node v = _graph.source(e);
-						if ((*_elevator)[v] == _elevator->maxLevel()) continue;
-						_flow->set(e, 0);
-						(*_excess)[v] += rem;
-					}
-				}
-				for (NodeIt n(_graph); n != INVALID; ++n)
-					if (n != _source && n != _target && _tolerance.positive((*_excess)[n]))
+				saturateSourceArcs();
+				for (NodeIt n(*_graph); n != INVALID; ++n)
+					if (n != _source && n != _target && _tolerance.positive(_nodes->excess(_graph->id(n))))
 						_elevator->activate(n);
 
 				return true;
@@ -384,45 +783,24 @@ namespace lemon{
             void init() {
                 createStructures();
 
-                for (NodeIt n(_graph); n != INVALID; ++n) {
-                    (*_excess)[n] = 0;
-                }
-
-                for (ArcIt e(_graph); e != INVALID; ++e) {
-                    _flow->set(e, 0);
-                }                
-                // use breadth-first search to add item
-                typename Digraph::template NodeMap<bool> reached(_graph, false);
-                reached[_target] = true;
-				reached[_source] = true;
-                _elevator->initStart();
-                _elevator->initAddItem(_target);
-                std::vector<Node> queue;
-                queue.push_back(_target);
-                while (!queue.empty()) {
-                    _elevator->initNewLevel();
-                    std::vector<Node> nqueue;
-                    for (int i = 0; i < queue.size(); i++) {
-                        Node n = queue[i];
-                        for (InArcIt e(_graph, n); e != INVALID; ++e) {
-                            Node u = _graph.source(e);
-                            if (!reached[u] && _tolerance.positive((*_capacity)[e])) {
-                                reached[u] = true;
-                                _elevator->initAddItem(u);
-                                nqueue.push_back(u);
-                            }
-                        }
-                    }
-                    queue.swap(nqueue);
+                for (NodeIt n(*_graph); n != INVALID; ++n) {
+                    _nodes->excess(_graph->id(n)) = 0;
                 }
-                _elevator->initFinish();
+                _res.setCapacity(*_graph, *_capacity);
+                _all_changed = true;
+                _relabel_work = 0;
+                _stats.clear();
+                _status = COMPLETED;
+                exactLabels(false);
                 
-                for(OutArcIt e(_graph, _source); e != INVALID; ++e){
-                    if(_tolerance.positive((*_capacity)[e])){
-                        Node u = _graph.target(e);
-                        _flow->set(e, (*_capacity)[e]);
-                        (*_excess)[u] += (*_capacity)[e];
-                        if(u != _target && !_elevator->active(u)){
+                int s = _graph->id(_source);
+                for (int a = _res.outBegin(s); a != _res.outEnd(s); ++a) {
+                    Value rem = _res.residual(a);
+                    if(_tolerance.positive(rem)){
+                        Node u = _graph->nodeFromId(_res.target(a));
+                        _res.augment(a, rem);
+                        _nodes->excess(_graph->id(u)) += rem;
+                        if(u != _target && u != _source && !_elevator->active(u)){
                             _elevator->activate(u);
                         }
                     }
@@ -431,88 +809,50 @@ namespace lemon{
             
             
             Value flowValue() const {
-                return (*_excess)[_target];
+                return _nodes->excess(_graph->id(_target));
             }
 
             inline void startFirstPhase() {
+                beginPhase();
                 pushRelabel(true);
             }
 
-            // the second phase calculate the minimal cut set
+            // the second phase returns the excess left by the first phase to
+            // the source and calculates the minimal cut sets, push-relabel
+            // above maxLevel() is only used if the first phase did not finish
             void startSecondPhase(bool getSourceSide = false) {
-                pushRelabel(false);
+                beginPhase();
+                if (!returnExcess()) {
+                    pushRelabel(false);
+                    if (_status == INTERRUPTED)
+                        return;
+                    get_min_sink_side();
+                }
 				if (getSourceSide)
 					get_min_source_side();
-				else
-					get_min_sink_side();
             }
+			// cut sides are found by a parallel breadth-first search
 			void get_min_source_side() {
-				for (NodeIt n(_graph); n != INVALID; ++n) {
-					_source_side[n] = false;
-				}
-				std::vector<Node> queue;
-				queue.push_back(_source);
-				_source_side[_source] = true;
-				// breadth-first search
-				while (!queue.empty()) {
-					std::vector<Node> nqueue;
-					for (int i = 0; i < int(queue.size()); i++) {
-						Node n = queue[i];
-						for (OutArcIt e(_graph, n); e != INVALID; ++e) {
-							Node u = _graph.target(e);
-							if (!_source_side[u] && _tolerance.positive((*_capacity)[e] - (*_flow)[e])) {
-								_source_side[u] = true;
-								nqueue.push_back(u);
-							}
-						}
-						for (InArcIt e(_graph, n); e != INVALID; ++e) {
-							Node u = _graph.source(e);
-							if (!_source_side[u] && _tolerance.positive((*_flow)[e])) {
-								_source_side[u] = true;
-								nqueue.push_back(u);
-							}
-						}
-					}
-					queue.swap(nqueue);
-				}
+				_source_side.assign(_res.nodeNum(), 0);
+				_bfs.reset(_res.nodeNum());
+				std::vector<char>& side = _source_side;
+				_bfs.search(_res, _tolerance, _graph->id(_source), false, 0,
+					[&side](int n, int) { side[n] = 1; });
 			}
 			void get_min_sink_side() {
-				for (NodeIt n(_graph); n != INVALID; ++n) {
-					_sink_side[n] = false;
-				}
-				std::vector<Node> queue;
-				queue.push_back(_target);
-				_sink_side[_target] = true;
-				// breadth-first search
-				while (!queue.empty()) {
-					std::vector<Node> nqueue;
-					for (int i = 0; i < int(queue.size()); i++) {
-						Node n = queue[i];
-						for (OutArcIt e(_graph, n); e != INVALID; ++e) {
-							Node u = _graph.target(e);
-							if (!_sink_side[u] && _tolerance.positive((*_flow)[e])) {
-								_sink_side[u] = true;
-								nqueue.push_back(u);
-							}
-						}
-						for (InArcIt e(_graph, n); e != INVALID; ++e) {
-							Node u = _graph.source(e);
-							if (!_sink_side[u] && _tolerance.positive((*_capacity)[e] - (*_flow)[e])) {
-								_sink_side[u] = true;
-								nqueue.push_back(u);
-							}
-						}
-					}
-					queue.swap(nqueue);
-				}
+				_sink_side.assign(_res.nodeNum(), 0);
+				_bfs.reset(_res.nodeNum());
+				std::vector<char>& side = _sink_side;
+				_bfs.search(_res, _tolerance, _graph->id(_target), true, 0,
+					[&side](int n, int) { side[n] = 1; });
 			}
 			// source side minCut
 			bool minCutSource(const Node& node) const {
-				return _source_side[node];
+				return _source_side[_graph->id(node)] != 0;
 			}
 			// returns true if node is source side cut of min sink side set
             bool minCut(const Node& node) const {
-                return !_sink_side[node];
+                return _sink_side[_graph->id(node)] == 0;
             }
 
             void runMinCut() {
@@ -520,11 +860,29 @@ namespace lemon{
                 startFirstPhase();
             }
 
-            void run() {
+            virtual void run() {
                 init();
                 startFirstPhase();
+                if (_status == INTERRUPTED)
+                    return;
                 startSecondPhase();
             }
+            // run until done or the token is set
+            Status run(const std::atomic<bool>& stop) {
+                const std::atomic<bool>* token = _stop_token;
+                _stop_token = &stop;
+                run();
+                _stop_token = token;
+                return _status;
+            }
+            // run until done or the deadline
+            Status run(TimePoint time) {
+                TimePoint old = _deadline;
+                _deadline = time;
+                run();
+                _deadline = old;
+                return _status;
+            }
     };
 	template <typename GR,
 		typename CAP = typename GR::template ArcMap<int>,
@@ -545,7 +903,18 @@ namespace lemon{
 				Node source, Node target) : Preflow_Base<GR, CAP,TR>(digraph, capacity, source, target) {}
 			void pushRelabel(bool limit_max_level) {
 				typename Elevator::iterator ele_it = this->_elevator->begin();
-				while (ele_it != this->_elevator->end()) {
+				// after a warm start (reinit, updateCapacities) the list need not be
+				// a topological order of the admissible arcs, so a pass which
+				// discharged a node is followed by another one
+				bool discharged = false;
+				while (true) {
+					if (ele_it == this->_elevator->end()) {
+						if (!discharged)
+							break;
+						discharged = false;
+						ele_it = this->_elevator->begin();
+						continue;
+					}
 					if (limit_max_level && (*(this->_elevator))[*ele_it] >= this->_elevator->maxLevel()) {
 						ele_it++;
 						continue;
@@ -554,9 +923,16 @@ namespace lemon{
 						ele_it++;
 						continue;
 					}
+					if (this->cancelled())
+						break;
 					Value old_label = (*(this->_elevator))[*ele_it];
 					this->discharge(*ele_it);
-					if ((*(this->_elevator))[*ele_it] > old_label) {
+					discharged = true;
+					if (this->globalRelabelDue()) {
+						this->globalRelabel();
+						ele_it = this->_elevator->begin();
+					}
+					else if ((*(this->_elevator))[*ele_it] > old_label) {
 						this->_elevator->moveToFront(ele_it);
 						ele_it = this->_elevator->begin();
 					}
@@ -586,8 +962,10 @@ namespace lemon{
 				Node source, Node target) : Preflow_Base<GR, CAP,TR>(digraph, capacity, source, target) {}
 			void pushRelabel(bool limit_max_level) {
 				Node current_discharge_node;
-				while (this->_elevator->getFront(current_discharge_node, limit_max_level)) {
+				while (!this->cancelled() && this->_elevator->getFront(current_discharge_node, limit_max_level)) {
 					this->discharge(current_discharge_node);
+					if (this->globalRelabelDue())
+						this->globalRelabel();
 				}		
 			}
 
@@ -612,8 +990,18 @@ namespace lemon{
                 Node source, Node target) : Preflow_Base<GR, CAP, TR>(digraph, capacity, source, target) {}
             void pushRelabel(bool limit_max_level) {
                 Node current_discharge_node;
-                while (this->_elevator->get_node_with_highest_label(current_discharge_node, limit_max_level)) {
+                Elevator*& _elevator = this->_elevator;
+                while (!this->cancelled() && _elevator->get_node_with_highest_label(current_discharge_node, limit_max_level)) {
+                    int old_level = (*_elevator)[current_discharge_node];
                     this->discharge(current_discharge_node);
+                    // gap heuristic: the nodes above an emptied level can no longer reach the target
+                    if ((*_elevator)[current_discharge_node] > old_level &&
+                        old_level < _elevator->maxLevel() && _elevator->emptyLevel(old_level)) {
+                        _elevator->liftToTop(old_level + 1);
+                        this->_stats.gap();
+                    }
+                    if (this->globalRelabelDue())
+                        this->globalRelabel();
                 }
             }
 
@@ -631,24 +1019,33 @@ namespace lemon{
 			typedef typename Traits::FlowMap FlowMap;
 			typedef typename Traits::Tolerance Tolerance;
 			typedef typename Traits::Elevator Elevator;
-            typedef typename Digraph::template NodeMap<Value> ExcessMap;
+			typedef typename Elevator::NodeState NodeState;
+			typedef lemon::ResidualGraph<Digraph, Value> ResidualGraph;
 		private:
 			TEMPLATE_DIGRAPH_TYPEDEFS(Digraph);
 		public:
 			Preflow_Parallel(const Digraph& digraph, const CapacityMap& capacity,
 				Node source, Node target) : Preflow_Base<GR, CAP,TR>(digraph, capacity, source, target) {
-
+				this->_global_relabel_freq = 0.5;
 			}
+			using Preflow_Base<GR, CAP, TR>::run;
             void run() {
                 this->init();
                 startFirstPhase();
+                if (this->_status == this->INTERRUPTED)
+                    return;
                 startSecondPhase();
             }
 			void pushRelabel(bool limit_max_level) {
 				Elevator*& _elevator = this->_elevator;
-				ExcessMap*& _excess = this->_excess;
+				NodeState* _nodes = this->_nodes;
+				const Digraph* _graph = this->_graph;
 				while( _elevator->get_active_count() > 0) {
 					int active_cnt = _elevator->get_active_count();
+					// checked between rounds, a round counts as its discharges
+					if (this->cancelled(active_cnt))
+						break;
+					this->_stats.round(active_cnt);
 					#pragma omp parallel for schedule(dynamic)
 					for (int i = 0; i < active_cnt; i++) {
 						#if OPENMP
@@ -658,6 +1055,19 @@ namespace lemon{
 						#endif
 						discharge(_elevator->get_node(i), thread_id);
 					}
+					// relabel after all pushes of the round, so that the arcs
+					// reversed by pushes into a node are taken into account
+					long long work = 0;
+					#pragma omp parallel for schedule(dynamic) reduction(+:work)
+					for (int i = 0; i < active_cnt; i++) {
+						#if OPENMP
+						int thread_id = omp_get_thread_num();
+						#else
+						int thread_id = 0;
+						#endif
+						work += relabel(_elevator->get_node(i), thread_id);
+					}
+					this->_relabel_work += work;
 
 					#pragma omp parallel for schedule(static)
 					for (int i = 0; i < _elevator->get_active_count(); i++) {
@@ -670,14 +1080,26 @@ namespace lemon{
 					#pragma omp parallel for schedule(static)
 					for (int i = 0; i < _elevator->get_active_count(); i++) {
 						Node n = _elevator->get_node(i);
-						(*_excess)[n] += _elevator->get_new_excess(n);
+						_nodes->excess(_graph->id(n)) += _elevator->get_new_excess(n);
 						_elevator->clear_new_excess(n);
 						_elevator->clear_discover(n);
 					}
+					if (this->globalRelabelDue())
+						globalRelabel();
 				}
 			}
             inline void startFirstPhase() {
-				this->_elevator->concatenate_active_sets();
+				// an interrupted phase stopped between rounds with the active set in place
+				bool resume = this->_status == this->INTERRUPTED;
+				this->beginPhase();
+				if (!resume) {
+					Elevator* _elevator = this->_elevator;
+					_elevator->concatenate_active_sets();
+					// the rounds expect the flags of the current set cleared
+					#pragma omp parallel for schedule(static)
+					for (int i = 0; i < _elevator->get_active_count(); i++)
+						_elevator->clear_discover(_elevator->get_node(i));
+				}
                 pushRelabel(true);
             }
             // the second phase calculate the minimal cut set
@@ -688,114 +1110,353 @@ namespace lemon{
 					this->get_min_sink_side();
             }
             Value flowValue() const {
-                return (*this->_excess)[this->_target] + this->_elevator->get_new_excess(this->_target);
+                return this->_nodes->excess(this->_graph->id(this->_target)) + this->_elevator->get_new_excess(this->_target);
             }
 		private:
-			
-            inline void relabel(const Node& n, int new_level) {
-	            this->_elevator->add_new_level(n, new_level + 1);
-            }
+			// parallel breadth-first search over the residual graph from the
+			// target, then from the source, levels are written to the elevator directly
+			void globalRelabel() {
+				Elevator* _elevator = this->_elevator;
+				const Digraph* _graph = this->_graph;
+				int node_num = this->_res.nodeNum();
+				int max_level = _elevator->maxLevel();
+				this->_relabel_work = 0;
+				this->_stats.globalRelabel();
+				this->_bfs.reset(node_num);
+				auto lift = [_elevator, _graph](int n, int level) {
+					_elevator->lift(_graph->nodeFromId(n), level);
+				};
+				this->_bfs.search(this->_res, this->_tolerance, _graph->id(this->_target), true, 0, lift);
+				// the source starts at level n
+				this->_bfs.search(this->_res, this->_tolerance, _graph->id(this->_source), true, max_level, lift);
+				// nodes reaching neither the target nor the source
+				#pragma omp parallel for schedule(static)
+				for (int i = 0; i < node_num; i++) {
+					if (!this->_bfs.reached(i))
+						_elevator->lift(_graph->nodeFromId(i), 2 * max_level - 1);
+				}
+				this->resetCurrentArcs();
+			}
+			// relabel a node which kept excess after the push pass, returns the work done
+			long long relabel(const Node& n, int thread_id) {
+				Elevator*& _elevator = this->_elevator;
+				ResidualGraph& _res = this->_res;
+				int i = this->_graph->id(n);
+				if (this->_nodes->excess(i) == 0)
+					return 0;
+				int new_level = this->minResidualLevel(i);
+				this->_nodes->current(i) = _res.outBegin(i);
+				if (new_level + 1 < 2 * _elevator->maxLevel())
+					_elevator->add_new_level(n, new_level + 1);
+				else
+					_elevator->add_new_level(n, 2 * _elevator->maxLevel() - 1);
+				_elevator->activate(n, thread_id);
+				this->_stats.relabel(thread_id);
+				return this->BETA + _res.outEnd(i) - _res.outBegin(i);
+			}
 
-			inline void push(const Node& u, const Node& v, const Arc& e, int thread_id) {
-				ExcessMap*& _excess = this->_excess;
+			inline void push(const Node& u, const Node& v, int a, int thread_id) {
 				Tolerance& _tolerance = this->_tolerance;
-				FlowMap*& _flow = this->_flow;
-				const CapacityMap*& _capacity = this->_capacity;
+				ResidualGraph& _res = this->_res;
 				Elevator*& _elevator = this->_elevator;
 
-                Value rem = (*_capacity)[e] - (*_flow)[e];
-                Value excess = (*_excess)[u];
-                if(_tolerance.less(rem, excess)){ // rem + epsilon < excess
+                Value rem = _res.residual(a);
+                Value& excess = this->_nodes->excess(this->_graph->id(u));
+                if (this->INTEGRAL) {
+                    Value delta = rem < excess ? rem : excess;
+                    this->_stats.push(rem < excess, !_res.forward(a), thread_id);
+                    excess -= delta;
+                    _elevator->add_new_excess(v, delta);
+                    _res.augment(a, delta);
+                }
+                else if(_tolerance.less(rem, excess)){ // rem + epsilon < excess
 					// saturating push
-					(*_excess)[u] -= rem;
+					excess -= rem;
 					_elevator->add_new_excess(v, rem);
-					_flow->set(e, (*_capacity)[e]);
+					_res.augment(a, rem);
+					this->_stats.push(true, !_res.forward(a), thread_id);
                 }
                 else {
 					// non-saturating push
-					(*_excess)[u] = 0;
 					_elevator->add_new_excess(v, excess);
-					_flow->set(e, (*_flow)[e] + excess);
+					_res.augment(a, excess);
+					excess = 0;
+					this->_stats.push(false, !_res.forward(a), thread_id);
                 }
-				if(v != this->_target && v != this->_source &&
-					_elevator->is_discovered(v) == false)
+				if(v != this->_target && v != this->_source)
 					_elevator->activate(v, thread_id);
 			}
-            inline void push_back(const Node& u, const Node& v, const Arc& e, int thread_id) {
-				ExcessMap*& _excess = this->_excess;
-				Tolerance& _tolerance = this->_tolerance;
-				FlowMap*& _flow = this->_flow;
-				const CapacityMap*& _capacity = this->_capacity;
-				Elevator*& _elevator = this->_elevator;
-
-                Value rem = (*_flow)[e];
-                Value excess = (*_excess)[u];
-                if(_tolerance.less(rem, excess)){
-                    // saturating push
-                    (*_excess)[u] -= rem;
-                    _elevator->add_new_excess(v, rem);
-                    _flow->set(e, 0);
-                }
-                else {
-                    // no saturating push
-                    (*_excess)[u] = 0;
-                    _elevator->add_new_excess(v, excess);
-                    _flow->set(e, (*_flow)[e] - excess);
-                }
-				if(v != this->_target && v != this->_source &&
-					_elevator->is_discovered(v) == false)
-					_elevator->activate(v, thread_id);				
-            }
 			void discharge(const Node& n, int thread_id) {
-				const Digraph& _graph = this->_graph;
+				const Digraph* _graph = this->_graph;
 				Elevator*& _elevator = this->_elevator;
-				ExcessMap*& _excess = this->_excess;
-				Tolerance& _tolerance = this->_tolerance;
-				FlowMap*& _flow = this->_flow;
-				const CapacityMap*& _capacity = this->_capacity;
+				NodeState* _nodes = this->_nodes;
+				ResidualGraph& _res = this->_res;
 				// save old label
 				_elevator->add_new_level(n, (*_elevator)[n]);
-				// discharge only, no actual relabel
-				int new_level = 2 * _elevator->maxLevel();
-				for(OutArcIt e(_graph, n); e != INVALID; ++e){
-					Node v = _graph.target(e);
-					if (_tolerance.positive((*_capacity)[e] - (*_flow)[e])){
-						if((*_elevator)[n] == (*_elevator)[v] + 1){
-							push(n, v, e, thread_id);
-						}
-						else if (new_level > (*_elevator)[v]) {
-							new_level = (*_elevator)[v];
+				this->_stats.discharge(thread_id);
+				// push only, the relabel pass follows
+				int i = _graph->id(n);
+				int& cur = _nodes->current(i);
+				const Value& excess = _nodes->excess(i);
+				for(; cur != _res.outEnd(i); ++cur){
+					if (this->positive(_res.residual(cur))){
+						int j = _res.target(cur);
+						if(_nodes->level(i) == _nodes->level(j) + 1){
+							push(n, _graph->nodeFromId(j), cur, thread_id);
+							if (excess == 0)
+								return;
 						}
-						if ((*_excess)[n] == 0)
-							break;
 					}
 				}
-				if ((*_excess)[n] == 0)
+			}
+	};
+
+	// asynchronous push-relabel after Hong: every thread discharges nodes
+	// from its own queue, pushes to the lowest residual neighbour or relabels,
+	// and updates residual capacities and excesses atomically. When the
+	// relabel work exceeds the global relabel threshold the threads stop,
+	// the labels are recomputed and the threads start again.
+	template <typename GR,
+		typename CAP = typename GR::template ArcMap<int>,
+		typename TR = Preflow_AsyncDefaultTraits<GR, CAP> >
+		class Preflow_Async : public Preflow_Base<GR, CAP, TR> {
+		public:
+			typedef TR Traits;
+			typedef typename Traits::Digraph Digraph;
+			typedef typename Traits::CapacityMap CapacityMap;
+			typedef typename Traits::Value Value;
+			typedef typename Traits::FlowMap FlowMap;
+			typedef typename Traits::Tolerance Tolerance;
+			typedef typename Traits::Elevator Elevator;
+			typedef lemon::ResidualGraph<Digraph, Value> ResidualGraph;
+		private:
+			TEMPLATE_DIGRAPH_TYPEDEFS(Digraph);
+			// atomic copies of the residual capacities and excesses used while
+			// the threads run. They are kept equal to _res and the node state
+			// between the calls: the entries changed by updateCapacities() are
+			// copied in, the ones changed by the threads are written back, so a
+			// warm start does not copy all arcs and nodes.
+			std::unique_ptr<std::atomic<Value>[]> _residual;
+			std::unique_ptr<std::atomic<Value>[]> _node_excess;
+			int _residual_size = 0;
+			int _excess_size = 0;
+			// entries written by the threads, listed once each thanks to the
+			// flags, so the lists never exceed the arc and node numbers
+			std::unique_ptr<std::atomic<bool>[]> _arc_touched;
+			std::unique_ptr<std::atomic<bool>[]> _node_touched;
+			std::unique_ptr<int[]> _touched_arcs;
+			std::unique_ptr<int[]> _touched_nodes;
+			std::atomic<int> _touched_arc_num;
+			std::atomic<int> _touched_node_num;
+			bool _limit_max_level = false;
+			std::atomic<long long> _work;
+			long long _work_limit = 0;
+			std::atomic<bool> _stop;
+			std::atomic<bool> _cancel;
+		public:
+			Preflow_Async(const Digraph& digraph, const CapacityMap& capacity,
+				Node source, Node target) : Preflow_Base<GR, CAP, TR>(digraph, capacity, source, target),
+				_touched_arc_num(0), _touched_node_num(0), _work(0), _stop(false), _cancel(false) {
+				this->_global_relabel_freq = 0.5;
+				this->_track_changes = true;
+			}
+			using Preflow_Base<GR, CAP, TR>::run;
+			void run() {
+				this->init();
+				startFirstPhase();
+				if (this->_status == this->INTERRUPTED)
 					return;
-				for(InArcIt e(_graph, n); e != INVALID; ++e) {
-					Node v = _graph.source(e);
+				this->startSecondPhase();
+			}
+			void pushRelabel(bool limit_max_level) {
+				ResidualGraph& _res = this->_res;
+				Elevator* _elevator = this->_elevator;
+				int arc_num = _res.arcNum();
+				int node_num = _res.nodeNum();
+				// grown only, as the scratch space of the other solvers
+				if (_residual_size < arc_num) {
+					_residual.reset(new std::atomic<Value>[arc_num]);
+					_arc_touched.reset(new std::atomic<bool>[arc_num]);
+					_touched_arcs.reset(new int[arc_num]);
+					for (int a = 0; a < arc_num; a++)
+						_arc_touched[a].store(false, std::memory_order_relaxed);
+					_residual_size = arc_num;
+					this->_all_changed = true;
+				}
+				if (_excess_size < node_num) {
+					_node_excess.reset(new std::atomic<Value>[node_num]);
+					_node_touched.reset(new std::atomic<bool>[node_num]);
+					_touched_nodes.reset(new int[node_num]);
+					for (int i = 0; i < node_num; i++)
+						_node_touched[i].store(false, std::memory_order_relaxed);
+					_excess_size = node_num;
+					this->_all_changed = true;
+				}
+				copyIn();
+				_limit_max_level = limit_max_level;
+				// nodes left above maxLevel() by the first phase
+				if (!limit_max_level) {
+					for (NodeIt n(*this->_graph); n != INVALID; ++n)
+						if (n != this->_source && n != this->_target && this->_tolerance.positive(this->_nodes->excess(this->_graph->id(n))))
+							_elevator->activate(n);
+				}
+				_work_limit = this->_global_relabel_freq > 0 ?
+					(long long)((this->ALPHA * node_num + arc_num / 2) / this->_global_relabel_freq) : -1;
+				while (true) {
+					_work.store(0);
+					_stop.store(false);
+					_cancel.store(false);
 
-					if (_tolerance.positive((*_flow)[e])){
-						if((*_elevator)[n] == (*_elevator)[v] + 1) {
-							push_back(n, v, e, thread_id); // push back the flow
-						}
-						else if (new_level > (*_elevator)[v]) {
-							new_level = (*_elevator)[v];
-						}
-						if ((*_excess)[n] == 0)
-							break;                            
+					// the queues of the elevator are one per thread
+					#pragma omp parallel num_threads(_elevator->threadCount())
+					{
+						#if OPENMP
+						int thread_id = omp_get_thread_num();
+						#else
+						int thread_id = 0;
+						#endif
+						work(thread_id);
 					}
+
+					copyOut();
+					if (_elevator->pending() == 0)
+						break;
+					if (_cancel.load()) {
+						this->_status = this->INTERRUPTED;
+						break;
+					}
+					// stopped for a global relabel, which queues the active nodes again
+					this->globalRelabel();
 				}
-				if ((*_excess)[n] == 0)
-					return;
-				if (new_level + 1 < 2 * _elevator->maxLevel()) {
-					relabel(n, new_level);
+			}
+			inline void startFirstPhase() {
+				this->beginPhase();
+				pushRelabel(true);
+			}
+		private:
+			// bring the atomic copies up to date with _res and the node state
+			void copyIn() {
+				ResidualGraph& _res = this->_res;
+				if (this->_all_changed) {
+					for (int a = 0; a < _res.arcNum(); a++)
+						_residual[a].store(_res.residual(a), std::memory_order_relaxed);
+					for (int i = 0; i < _res.nodeNum(); i++)
+						_node_excess[i].store(this->_nodes->excess(i), std::memory_order_relaxed);
 				}
 				else {
-					relabel(n, 2 * _elevator->maxLevel() - 2);
+					for (int a : this->_changed_arcs) {
+						_residual[a].store(_res.residual(a), std::memory_order_relaxed);
+						_residual[_res.pair(a)].store(_res.residual(_res.pair(a)), std::memory_order_relaxed);
+					}
+					for (int i : this->_changed_nodes)
+						_node_excess[i].store(this->_nodes->excess(i), std::memory_order_relaxed);
+				}
+				this->_all_changed = false;
+				this->_changed_arcs.clear();
+				this->_changed_nodes.clear();
+			}
+			// write the entries changed by the threads back
+			void copyOut() {
+				ResidualGraph& _res = this->_res;
+				for (int k = 0; k < _touched_arc_num.load(); k++) {
+					int a = _touched_arcs[k];
+					_res.residual(a) = _residual[a].load(std::memory_order_relaxed);
+					_res.residual(_res.pair(a)) = _residual[_res.pair(a)].load(std::memory_order_relaxed);
+					_arc_touched[a].store(false, std::memory_order_relaxed);
+				}
+				for (int k = 0; k < _touched_node_num.load(); k++) {
+					int i = _touched_nodes[k];
+					this->_nodes->excess(i) = _node_excess[i].load(std::memory_order_relaxed);
+					_node_touched[i].store(false, std::memory_order_relaxed);
+				}
+				_touched_arc_num.store(0);
+				_touched_node_num.store(0);
+			}
+			void touchArc(int a) {
+				if (!_arc_touched[a].load(std::memory_order_relaxed) && !_arc_touched[a].exchange(true))
+					_touched_arcs[_touched_arc_num.fetch_add(1)] = a;
+			}
+			void touchNode(int i) {
+				if (!_node_touched[i].load(std::memory_order_relaxed) && !_node_touched[i].exchange(true))
+					_touched_nodes[_touched_node_num.fetch_add(1)] = i;
+			}
+			void work(int thread_id) {
+				Elevator* _elevator = this->_elevator;
+				int countdown = 0;
+				Node n;
+				while (_elevator->pending() > 0 && !_stop.load(std::memory_order_relaxed)) {
+					// each thread checks the cancellation every check interval discharges
+					if (--countdown <= 0) {
+						countdown = this->_check_interval;
+						if (this->cancelRequested()) {
+							_cancel.store(true);
+							_stop.store(true);
+							break;
+						}
+					}
+					if (!_elevator->pop(n, thread_id)) {
+						std::this_thread::yield();
+						continue;
+					}
+					if (!_limit_max_level || (*_elevator)[n] < _elevator->maxLevel())
+						discharge(n, thread_id);
+					_elevator->deactivate(n);
+					// excess pushed to n after the discharge did not queue it
+					if (this->_tolerance.positive(_node_excess[this->_graph->id(n)].load()) &&
+						(!_limit_max_level || (*_elevator)[n] < _elevator->maxLevel()))
+						_elevator->activate(n, thread_id);
+					_elevator->done();
+				}
+			}
+			// thread_id picks the queue and the statistics slot of the thread
+			void discharge(const Node& n, int thread_id) {
+				const Digraph* _graph = this->_graph;
+				const ResidualGraph& _res = this->_res;
+				Elevator* _elevator = this->_elevator;
+				int i = _graph->id(n);
+				int max_label = 2 * _elevator->maxLevel();
+				Value excess;
+				this->_stats.discharge(thread_id);
+				while (this->positive(excess = _node_excess[i].load())) {
+					// only this thread lowers the residual capacities leaving n,
+					// others can only raise them
+					int lowest = max_label, lowest_arc = -1;
+					for (int a = _res.outBegin(i); a != _res.outEnd(i); ++a) {
+						if (this->positive(_residual[a].load(std::memory_order_relaxed))) {
+							int level = this->_nodes->level(_res.target(a)).load(std::memory_order_relaxed);
+							if (level < lowest) {
+								lowest = level;
+								lowest_arc = a;
+							}
+						}
+					}
+					if (lowest_arc < 0)
+						break;
+					if ((*_elevator)[n] > lowest) {
+						Value rem = _residual[lowest_arc].load(std::memory_order_relaxed);
+						Value delta = this->less(rem, excess) ? rem : excess;
+						Node v = _graph->nodeFromId(_res.target(lowest_arc));
+						atomicAdd(_residual[lowest_arc], -delta);
+						atomicAdd(_residual[_res.pair(lowest_arc)], delta);
+						atomicAdd(_node_excess[i], -delta);
+						atomicAdd(_node_excess[_res.target(lowest_arc)], delta);
+						touchArc(lowest_arc);
+						touchNode(i);
+						touchNode(_res.target(lowest_arc));
+						this->_stats.push(delta == rem, !_res.forward(lowest_arc), thread_id);
+						if (v != this->_source && v != this->_target)
+							_elevator->activate(v, thread_id);
+					}
+					else {
+						_elevator->lift(n, lowest + 1);
+						this->_stats.relabel(thread_id);
+						long long w = this->BETA + _res.outEnd(i) - _res.outBegin(i);
+						if (_work_limit >= 0 && _work.fetch_add(w, std::memory_order_relaxed) + w > _work_limit)
+							_stop.store(true, std::memory_order_relaxed);
+						if (_limit_max_level && lowest + 1 >= _elevator->maxLevel())
+							break;
+					}
 				}
-				if (_elevator->is_discovered(n) == false)
-					_elevator->activate(n, thread_id);
 			}
 	};
 }
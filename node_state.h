@@ -0,0 +1,95 @@
+#pragma once
+#include <memory>
+namespace lemon {
+    // hot per node state of the push-relabel solvers, indexed by node id:
+    // the label, the excess and the current residual arc. The elevator owns
+    // it, so it moves with the elevator on a warm start, and the solver reads
+    // the excess and the current arc from the same place. L is the label
+    // type, std::atomic<int> for the asynchronous solver.
+
+    // one record per node (AoS), a discharge finds the label, excess and
+    // current arc of its node on one cache line
+    template <typename V, typename L = int>
+    class PackedNodeState {
+        struct Record {
+            V excess;
+            L level;
+            int current;
+        };
+        std::unique_ptr<Record[]> _nodes;
+        int _size;
+        int _capacity;
+    public:
+        typedef V Value;
+        PackedNodeState() : _size(0), _capacity(0) {}
+        PackedNodeState(const PackedNodeState& s) : _size(0), _capacity(0) {
+            resize(s._size);
+            for (int i = 0; i < _size; i++) {
+                _nodes[i].excess = s._nodes[i].excess;
+                _nodes[i].level = static_cast<int>(s._nodes[i].level);
+                _nodes[i].current = s._nodes[i].current;
+            }
+        }
+        // n nodes, all zero, reallocated only if n exceeds the capacity
+        void resize(int n) {
+            if (n > _capacity) {
+                _nodes.reset(new Record[n]);
+                _capacity = n;
+            }
+            _size = n;
+            for (int i = 0; i < n; i++) {
+                _nodes[i].excess = 0;
+                _nodes[i].level = 0;
+                _nodes[i].current = 0;
+            }
+        }
+        int size() const { return _size; }
+        L& level(int i) { return _nodes[i].level; }
+        const L& level(int i) const { return _nodes[i].level; }
+        V& excess(int i) { return _nodes[i].excess; }
+        const V& excess(int i) const { return _nodes[i].excess; }
+        int& current(int i) { return _nodes[i].current; }
+    };
+
+    // one array per field (SoA), the label checks of the neighbours in a
+    // discharge scan a dense array of labels only
+    template <typename V, typename L = int>
+    class SplitNodeState {
+        std::unique_ptr<V[]> _excess;
+        std::unique_ptr<L[]> _level;
+        std::unique_ptr<int[]> _current;
+        int _size;
+        int _capacity;
+    public:
+        typedef V Value;
+        SplitNodeState() : _size(0), _capacity(0) {}
+        SplitNodeState(const SplitNodeState& s) : _size(0), _capacity(0) {
+            resize(s._size);
+            for (int i = 0; i < _size; i++) {
+                _excess[i] = s._excess[i];
+                _level[i] = static_cast<int>(s._level[i]);
+                _current[i] = s._current[i];
+            }
+        }
+        void resize(int n) {
+            if (n > _capacity) {
+                _excess.reset(new V[n]);
+                _level.reset(new L[n]);
+                _current.reset(new int[n]);
+                _capacity = n;
+            }
+            _size = n;
+            for (int i = 0; i < n; i++) {
+                _excess[i] = 0;
+                _level[i] = 0;
+                _current[i] = 0;
+            }
+        }
+        int size() const { return _size; }
+        L& level(int i) { return _level[i]; }
+        const L& level(int i) const { return _level[i]; }
+        V& excess(int i) { return _excess[i]; }
+        const V& excess(int i) const { return _excess[i]; }
+        int& current(int i) { return _current[i]; }
+    };
+}
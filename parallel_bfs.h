@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+namespace lemon {
+    // breadth-first search over a ResidualGraph, parallel with OpenMP.
+    // A forward search follows residual arcs away from the root, a backward
+    // search finds the nodes with a residual path to the root. Each level is
+    // expanded either top-down from a frontier queue or, when the frontier is
+    // large, bottom-up by letting every unvisited node look for a frontier
+    // neighbour (direction-optimizing BFS). All scratch space is kept between
+    // searches, so repeated searches do not allocate.
+    template <typename RG, typename TOL>
+    class ParallelBfs {
+        typedef typename RG::Value Value;
+
+        std::unique_ptr<std::atomic<char>[]> _visited;
+        std::vector<char> _in_frontier;
+        std::vector<char> _in_next;
+        // the current and the next frontier queue, node_num long each
+        std::vector<int> _frontier;
+        std::vector<int> _next;
+        int _node_num = 0;
+        int _visited_capacity = 0;
+
+        // top-down to bottom-up when the frontier arcs exceed the unexplored arcs / ALPHA,
+        // back when the frontier has less than node_num / BETA nodes
+        static const int ALPHA = 14;
+        static const int BETA = 24;
+        // nodes a thread collects before it claims room in the next frontier
+        static const int LOCAL = 256;
+
+        // residual capacity of the arc the search crosses when it reaches
+        // target(a) from the tail of a
+        static Value forwardResidual(const RG& res, int a, bool backward) {
+            return backward ? res.residual(res.pair(a)) : res.residual(a);
+        }
+        bool mark(int i) {
+            return !_visited[i].load(std::memory_order_relaxed) &&
+                !_visited[i].exchange(1, std::memory_order_relaxed);
+        }
+
+    public:
+        // clear the visited marks, to be called before the first search
+        void reset(int node_num) {
+            if (node_num > _visited_capacity) {
+                _visited.reset(new std::atomic<char>[node_num]);
+                _visited_capacity = node_num;
+            }
+            if (_node_num != node_num) {
+                _in_frontier.assign(node_num, 0);
+                _in_next.assign(node_num, 0);
+                _frontier.resize(node_num);
+                _next.resize(node_num);
+                _node_num = node_num;
+            }
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < node_num; i++)
+                _visited[i].store(0, std::memory_order_relaxed);
+        }
+        bool reached(int i) const {
+            return _visited[i].load(std::memory_order_relaxed) != 0;
+        }
+
+        // search from root, skipping nodes reached by earlier searches since
+        // reset(). visit(node, level) is called once for every newly reached
+        // node, from any thread, the root gets start_level.
+        template <typename Visit>
+        void search(const RG& res, const TOL& tolerance, int root, bool backward,
+            int start_level, Visit visit) {
+            if (!mark(root))
+                return;
+            visit(root, start_level);
+            _frontier[0] = root;
+            int level = start_level;
+            long long unexplored_arcs = res.arcNum();
+            bool bottom_up = false;
+            int frontier_size = 1;
+            while (frontier_size > 0) {
+                level++;
+                long long frontier_arcs = 0;
+                if (!bottom_up) {
+                    #pragma omp parallel for schedule(static) reduction(+:frontier_arcs)
+                    for (int k = 0; k < frontier_size; k++)
+                        frontier_arcs += res.outEnd(_frontier[k]) - res.outBegin(_frontier[k]);
+                    unexplored_arcs -= frontier_arcs;
+                }
+                bool next_bottom_up = bottom_up ?
+                    (long long)frontier_size * BETA >= _node_num :
+                    frontier_arcs * ALPHA > unexplored_arcs;
+                if (next_bottom_up && !bottom_up) {
+                    // queue to bitmap
+                    #pragma omp parallel for schedule(static)
+                    for (int i = 0; i < _node_num; i++)
+                        _in_frontier[i] = 0;
+                    #pragma omp parallel for schedule(static)
+                    for (int k = 0; k < frontier_size; k++)
+                        _in_frontier[_frontier[k]] = 1;
+                }
+                else if (!next_bottom_up && bottom_up) {
+                    // bitmap to queue
+                    frontier_size = 0;
+                    for (int i = 0; i < _node_num; i++)
+                        if (_in_frontier[i])
+                            _frontier[frontier_size++] = i;
+                }
+                bottom_up = next_bottom_up;
+                if (bottom_up) {
+                    int next_size = 0;
+                    #pragma omp parallel for schedule(dynamic, 256) reduction(+:next_size)
+                    for (int u = 0; u < _node_num; u++) {
+                        _in_next[u] = 0;
+                        if (_visited[u].load(std::memory_order_relaxed))
+                            continue;
+                        for (int a = res.outBegin(u); a != res.outEnd(u); ++a) {
+                            // arc a leads from u to a frontier node w, the search crosses
+                            // the opposite arc from w to u
+                            if (_in_frontier[res.target(a)] &&
+                                tolerance.positive(forwardResidual(res, res.pair(a), backward))) {
+                                _visited[u].store(1, std::memory_order_relaxed);
+                                _in_next[u] = 1;
+                                visit(u, level);
+                                next_size++;
+                                break;
+                            }
+                        }
+                    }
+                    _in_frontier.swap(_in_next);
+                    frontier_size = next_size;
+                }
+                else {
+                    // every node is marked once, so the next frontier fits
+                    // into _next, threads copy their nodes there in blocks
+                    std::atomic<int> next_size(0);
+                    #pragma omp parallel
+                    {
+                        int local[LOCAL];
+                        int local_size = 0;
+                        #pragma omp for schedule(dynamic, 64)
+                        for (int k = 0; k < frontier_size; k++) {
+                            int n = _frontier[k];
+                            for (int a = res.outBegin(n); a != res.outEnd(n); ++a) {
+                                int u = res.target(a);
+                                if (tolerance.positive(forwardResidual(res, a, backward)) && mark(u)) {
+                                    visit(u, level);
+                                    local[local_size++] = u;
+                                    if (local_size == LOCAL) {
+                                        int pos = next_size.fetch_add(local_size, std::memory_order_relaxed);
+                                        std::copy(local, local + local_size, _next.begin() + pos);
+                                        local_size = 0;
+                                    }
+                                }
+                            }
+                        }
+                        int pos = next_size.fetch_add(local_size, std::memory_order_relaxed);
+                        std::copy(local, local + local_size, _next.begin() + pos);
+                    }
+                    _frontier.swap(_next);
+                    frontier_size = next_size.load();
+                }
+            }
+        }
+    };
+}
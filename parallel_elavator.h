@@ -1,120 +1,201 @@
 #include <vector>
+#include <list>
+#include <memory>
 #include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <type_traits>
 #ifdef OPENMP
 #include <omp.h>
 #endif
+#include "preflow_statistics.h"
+#include "node_state.h"
+#include "cache_aligned.h"
 namespace lemon{
-    template<class GR, class Item, class Value = int>
+    // lock-free a += d, fetch_add for integers and a compare and swap loop otherwise
+    template <typename V>
+    inline typename std::enable_if<std::is_integral<V>::value>::type
+    atomicAdd(std::atomic<V>& a, V d) {
+        a.fetch_add(d, std::memory_order_relaxed);
+    }
+    template <typename V>
+    inline typename std::enable_if<!std::is_integral<V>::value>::type
+    atomicAdd(std::atomic<V>& a, V d) {
+        V old = a.load(std::memory_order_relaxed);
+        while (!a.compare_exchange_weak(old, old + d, std::memory_order_relaxed)) {}
+    }
+    template<class GR, class Item, class Value = int, class State = PackedNodeState<Value> >
     class ParallelElevator{
         // parallel elevator
     private:
         struct VertexExtraInfo
         {
-            Value new_excess;
-#ifdef OPENMP           
-            omp_lock_t new_excess_write_lock;
-#endif           
+            std::atomic<Value> new_excess{0};
             int new_level;
-            std::atomic_flag discovered = ATOMIC_FLAG_INIT; // avoid duplicate add
+            // in the active set of the next round, avoids duplicate adds
+            std::atomic<bool> discovered{false};
+        };
+        // nodes activated by one thread, copied to _next when full
+        static const int LOCAL = 256;
+        struct LocalBlock {
+            int items[LOCAL];
+            int count = 0;
         };
 
     public:
         typedef typename std::list<Item>::iterator iterator; 
 		typedef typename GR::NodeIt NodeIt;
         typedef typename GR::Node Node;
+        typedef State NodeState;
     private:
         typedef typename ItemSetTraits<GR, Item>::
         template Map<int>::Type IntMap;
         typedef typename ItemSetTraits<GR, Item>::
         template Map<bool>::Type BoolMap;
         
-        const GR &_graph;
+        const GR* _graph;
         int _max_level;
-        IntMap _level;
-        std::unique_ptr<VertexExtraInfo[]> _vertices;        
-        std::unique_ptr<std::vector<int>[]> _active_local; // thread local structure
+        State _state;
+        std::unique_ptr<VertexExtraInfo[]> _vertices;
+        int _vertex_capacity = 0;
+        CacheAlignedArray<LocalBlock> _active_local; // thread local structure
         int _thread_cnt;
+        // the active nodes of the current round, the first _active_count
         std::vector<int> active_nodes;
+        int _active_count = 0;
+        // the nodes activated for the next round, filled from the blocks of
+        // the threads, blocks which do not fit go to _spill and make _next
+        // grow for the later rounds, so the rounds do not allocate
+        std::vector<int> _next;
+        std::atomic<int> _next_size{0};
+        int _next_valid = 0;
+        std::vector<int> _spill;
+        std::mutex _spill_lock;
+
+        void flush(LocalBlock& block) {
+            int pos = _next_size.fetch_add(block.count, std::memory_order_relaxed);
+            if (pos + block.count <= int(_next.size())) {
+                std::copy(block.items, block.items + block.count, _next.begin() + pos);
+            }
+            else {
+                std::lock_guard<std::mutex> guard(_spill_lock);
+                _spill.insert(_spill.end(), block.items, block.items + block.count);
+                _next_valid = std::min(_next_valid, pos);
+            }
+            block.count = 0;
+        }
+        void clearActive() {
+            for (int i = 0; i < _thread_cnt; i++)
+                _active_local[i].count = 0;
+            _next_size.store(0);
+            _next_valid = int(_next.size());
+            _spill.clear();
+            _active_count = 0;
+        }
 
     public:
 		ParallelElevator(const GR& graph, int max_level, int thread_count = 1)
-        : _graph(graph), _max_level(max_level),
-          _level(graph), _init_level(0), _thread_cnt(thread_count) {
-              int node_num  = countNodes(graph);
-              _vertices = std::make_unique<VertexExtraInfo[]>(node_num);
-#ifdef OPENMP
-              for (int i = 0; i < node_num; i++) {
-                  omp_init_lock(&_vertices[i].new_excess_write_lock);
-              }
-#endif
-              _active_local = std::make_unique<std::vector<int>[]>(thread_count);
+        : _graph(&graph), _max_level(max_level),
+          _active_local(thread_count), _thread_cnt(thread_count), _init_level(0) {
+              reset(graph, max_level);
 		}
 
+        // rebind to a graph, the arrays keep their memory if it suffices
+        void reset(const GR& graph, int max_level) {
+            int item_num = graph.maxNodeId() + 1;
+            _graph = &graph;
+            _max_level = max_level;
+            _state.resize(item_num);
+            if (item_num > _vertex_capacity) {
+                _vertices = std::make_unique<VertexExtraInfo[]>(item_num);
+                _vertex_capacity = item_num;
+            }
+            if (item_num > int(_next.size())) {
+                _next.resize(item_num);
+                active_nodes.resize(item_num);
+            }
+            clearActive();
+        }
+
         int get_active_count() {
-            return active_nodes.size();
+            return _active_count;
         }
 
         Node get_node(int i) {
-            return _graph.nodeFromId(active_nodes[i]);
+            return _graph->nodeFromId(active_nodes[i]);
         }
 
 		ParallelElevator(const ParallelElevator& ele) {
 
 		}
+        // the nodes activated since the last call become the active set
         void concatenate_active_sets() {
-            active_nodes.clear();
-            for(int i = 0; i < _thread_cnt; i++) {
-                active_nodes.insert(active_nodes.end(), _active_local[i].begin(), _active_local[i].end());
-                _active_local[i].clear();
+            for (int i = 0; i < _thread_cnt; i++)
+                flush(_active_local[i]);
+            int count = std::min(_next_size.load(), _next_valid);
+            if (!_spill.empty()) {
+                int size = count + int(_spill.size());
+                if (size > int(_next.size())) {
+                    _next.resize(size);
+                    active_nodes.resize(size);
+                }
+                std::copy(_spill.begin(), _spill.end(), _next.begin() + count);
+                count = size;
             }
-        }
+            active_nodes.swap(_next);
+            _active_count = count;
+            _next_size.store(0);
+            _next_valid = int(_next.size());
+            _spill.clear();
+        }
+        // add to the active set of the next round, an item already added
+        // since the last clear_discover() is skipped
         void activate(Item i, int thread_id = 0) {
-            _active_local[thread_id].push_back(_graph.id(i));
+            if (_vertices[_graph->id(i)].discovered.exchange(true, std::memory_order_relaxed))
+                return;
+            LocalBlock& block = _active_local[thread_id];
+            block.items[block.count++] = _graph->id(i);
+            if (block.count == LOCAL)
+                flush(block);
         }
 
         inline void deactivate(Item i) {
         }
         
-        inline bool is_discovered(Item i) {
-            return _vertices[_graph.id(i)].discovered.test_and_set(std::memory_order_relaxed);
-        }
         inline void clear_discover(Item i) {
-            _vertices[_graph.id(i)].discovered.clear(std::memory_order_relaxed);
+            _vertices[_graph->id(i)].discovered.store(false, std::memory_order_relaxed);
         }
-        inline bool active(Item i) const { return false; }
-#ifdef OPENMP
-        inline void add_new_excess(Item i, Value excess_value) {
-            VertexExtraInfo& v_info = _vertices[_graph.id(i)];
-            omp_set_lock(&v_info.new_excess_write_lock);
-            v_info.new_excess += excess_value;
-            omp_unset_lock(&v_info.new_excess_write_lock);
+        inline bool active(Item i) const {
+            return _vertices[_graph->id(i)].discovered.load(std::memory_order_relaxed);
         }
-#else
         inline void add_new_excess(Item i, Value excess_value) {
-            _vertices[_graph.id(i)].new_excess += excess_value;
+            atomicAdd(_vertices[_graph->id(i)].new_excess, excess_value);
         }
-#endif
         inline void clear_new_excess(Item i) {
-            _vertices[_graph.id(i)].new_excess = 0;
+            _vertices[_graph->id(i)].new_excess.store(0, std::memory_order_relaxed);
         }
         inline Value get_new_excess(Item i) {
-            return _vertices[_graph.id(i)].new_excess;
+            return _vertices[_graph->id(i)].new_excess.load(std::memory_order_relaxed);
         }
         inline void add_new_level(Item i, int level_value) {
-             _vertices[_graph.id(i)].new_level = level_value;
+             _vertices[_graph->id(i)].new_level = level_value;
         }
         inline int get_new_level(Item i) {
-            return  _vertices[_graph.id(i)].new_level;
+            return  _vertices[_graph->id(i)].new_level;
         }
-        int operator[](Item i) const { return _level[i]; }
+        int operator[](Item i) const { return _state.level(_graph->id(i)); }
 
         void lift(Item i, int new_level) {
-            _level[i] = new_level;
+            _state.level(_graph->id(i)) = new_level;
         }
 
         int maxLevel() const {
             return _max_level;
         }
+        // label, excess and current arc of the items, shared with the solver
+        State& nodeState() {
+            return _state;
+        }
         
     private:
         
@@ -123,27 +204,33 @@ namespace lemon{
     public:
         
         void initStart() {
-            for(typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for(typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                _level[i] = -1;
+                _state.level(_graph->id(i)) = -1;
+                // the terminals of a previous run keep their new excess
+                clear_new_excess(i);
+                clear_discover(i);
             }
+            clearActive();
+            _init_level = 0;
         }
         void initAddItem(Item i) {
-            _level[i] = _init_level;            
+            _state.level(_graph->id(i)) = _init_level;            
         }
         void initNewLevel() {
             ++_init_level;
         }
         void initFinish() {            
-            for (typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for (typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                if (_level[i] == -1) {
-                    _level[i] = _max_level;
+                if (_state.level(_graph->id(i)) == -1) {
+                    _state.level(_graph->id(i)) = _max_level;
                 }
             }
         }
     };
-	template <typename GR, typename CAP>
+	template <typename GR, typename CAP,
+		typename NS = PackedNodeState<typename CAP::Value> >
 	struct Preflow_ParallelDefaultTraits {
 		typedef GR Digraph;
 		typedef CAP CapacityMap;
@@ -152,7 +239,8 @@ namespace lemon{
 		static FlowMap* createFlowMap(const Digraph& digraph) {
 			return new FlowMap(digraph);
 		}
-		typedef ParallelElevator<Digraph, typename Digraph::Node, Value> Elevator;
+		typedef NS NodeState;
+		typedef ParallelElevator<Digraph, typename Digraph::Node, Value, NodeState> Elevator;
 		static Elevator* createElevator(const Digraph& digraph, int max_level) {
             #if OPENMP
             int thread_cnt = omp_get_max_threads();
@@ -162,5 +250,6 @@ namespace lemon{
 			return new Elevator(digraph, max_level, thread_cnt);
 		}
 		typedef lemon::Tolerance<Value> Tolerance;
+		typedef NoPreflowStatistics Statistics;
 	};    
 }
\ No newline at end of file
@@ -0,0 +1,520 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <lemon/core.h>
+#include <lemon/tolerance.h>
+#include <lemon/list_graph.h>
+#include "mf_base.h"
+
+namespace lemon {
+    // parametric maximum flow: the capacity of arc e at lambda is
+    // capacity[e] + lambda * slope[e], slopes are nonnegative on the arcs
+    // leaving the source, nonpositive on the arcs entering the target and 0
+    // elsewhere, and no capacity may become negative on [lambda_min, lambda_max],
+    // run() throws std::invalid_argument otherwise. Then the minimum cut value
+    // is a concave piecewise linear function of lambda and the minimum cuts
+    // are nested.
+    // run() is the monotone sweep of Gallo, Grigoriadis and Tarjan: lambda
+    // only grows, a Preflow_HL keeps its preflow and labels between the
+    // lambdas and updateCapacities() changes only the arcs of the terminals.
+    // The next lambda is the intersection of the cut line of the settled
+    // source side and the line of a minimum cut at lambda_max. The nodes
+    // lifted to maxLevel() join the source side, they are contracted
+    // and the cut line is updated from their arcs only. An interval skipped
+    // that way is solved by another sweep on the network of the nodes that
+    // joined, with the settled side contracted into the source and the rest
+    // into the target.
+    template <typename GR, typename CAP>
+    class ParametricPreflow {
+    public:
+        typedef GR Digraph;
+        typedef CAP CapacityMap;
+        // capacities and slopes, the cut lines are summed in this type
+        typedef typename CAP::Value Value;
+        // lambda and the flows at a lambda, which are fractional for
+        // integral capacities
+        typedef typename std::conditional<std::numeric_limits<Value>::is_integer,
+            double, Value>::type Real;
+    private:
+        TEMPLATE_DIGRAPH_TYPEDEFS(Digraph);
+
+        // value of a cut as a function of lambda
+        struct Line {
+            Value a, b;
+            Real operator()(Real lambda) const { return a + b * lambda; }
+            bool zero() const { return a == 0 && b == 0; }
+            void add(const Line& l) {
+                a += l.a;
+                b += l.b;
+            }
+            void subtract(const Line& l) {
+                a -= l.a;
+                b -= l.b;
+            }
+        };
+        struct Breakpoint {
+            Real lambda;
+            // cut line after the breakpoint
+            Line right;
+            bool operator<(const Breakpoint& bp) const {
+                return lambda < bp.lambda || (lambda == bp.lambda && right.b > bp.right.b);
+            }
+        };
+
+        struct NetworkArc {
+            int source, target;
+            Line capacity;
+        };
+        // network of one sweep, node 0 is the source, node 1 the target and
+        // the others stand for the original nodes in node, by id. The arcs
+        // between a terminal and a node are merged into one.
+        struct Network {
+            ListDigraph graph;
+            std::vector<Node> node;
+            ListDigraph::ArcMap<Line> line;
+            // capacities at the lambda of the last update
+            ListDigraph::ArcMap<Real> capacity;
+            // arc from the source and to the target of each node, by id
+            std::vector<ListDigraph::Arc> source_arc, target_arc;
+
+            Network() : line(graph), capacity(graph) {}
+            int nodeNum() const { return int(node.size()); }
+
+            void build(const std::vector<NetworkArc>& arcs) {
+                const Line zero = { 0, 0 };
+                int node_num = nodeNum();
+                std::vector<Line> from_source(node_num, zero), to_target(node_num, zero);
+                std::vector<NetworkArc> list;
+                for (const NetworkArc& e : arcs) {
+                    // arcs into the source or out of the target never cross a cut,
+                    // arcs from the source to the target cross all of them
+                    if (e.source == e.target || e.target == 0 || e.source == 1 ||
+                        (e.source == 0 && e.target == 1) || e.capacity.zero())
+                        continue;
+                    if (e.source == 0)
+                        from_source[e.target].add(e.capacity);
+                    else if (e.target == 1)
+                        to_target[e.source].add(e.capacity);
+                    else
+                        list.push_back(e);
+                }
+                graph.reserveNode(node_num);
+                for (int v = 0; v < node_num; v++)
+                    graph.addNode();
+                source_arc.assign(node_num, INVALID);
+                target_arc.assign(node_num, INVALID);
+                for (int v = 2; v < node_num; v++) {
+                    if (!from_source[v].zero()) {
+                        NetworkArc e = { 0, v, from_source[v] };
+                        list.push_back(e);
+                    }
+                    if (!to_target[v].zero()) {
+                        NetworkArc e = { v, 1, to_target[v] };
+                        list.push_back(e);
+                    }
+                }
+                graph.reserveArc(int(list.size()));
+                for (const NetworkArc& e : list) {
+                    ListDigraph::Arc a = graph.addArc(graph.nodeFromId(e.source),
+                        graph.nodeFromId(e.target));
+                    line.set(a, e.capacity);
+                    if (e.source == 0)
+                        source_arc[e.target] = a;
+                    if (e.target == 1)
+                        target_arc[e.source] = a;
+                }
+            }
+        };
+
+        // Preflow_HL on a Network which keeps its preflow and labels when
+        // lambda grows. The nodes reaching maxLevel() in the first phase form
+        // the source side of a minimum cut with the settled nodes, settle()
+        // contracts them into the source: their arcs are not updated any more.
+        class Sweep : public Preflow_HL<ListDigraph, ListDigraph::ArcMap<Real> > {
+            typedef Preflow_HL<ListDigraph, ListDigraph::ArcMap<Real> > Parent;
+            Network& _net;
+            std::vector<char> _settled;
+            std::vector<char> _lifted_flag;
+            std::vector<int> _lifted;
+            // unsettled nodes with an arc of a terminal
+            std::vector<int> _param, _param_pos;
+            std::vector<std::pair<ListDigraph::Arc, Real> > _changes;
+            bool _started;
+            // the first phase after init() reads all levels
+            bool _scan;
+
+            void addLifted(int v) {
+                if (_settled[v] || _lifted_flag[v] ||
+                    (*this->_elevator)[_net.graph.nodeFromId(v)] < this->_elevator->maxLevel())
+                    return;
+                _lifted_flag[v] = 1;
+                _lifted.push_back(v);
+            }
+            void removeParam(int v) {
+                int i = _param_pos[v];
+                if (i < 0)
+                    return;
+                _param[i] = _param.back();
+                _param_pos[_param[i]] = i;
+                _param.pop_back();
+                _param_pos[v] = -1;
+            }
+            void setCapacity(ListDigraph::Arc a, Real lambda) {
+                Real capacity = _net.line[a](lambda);
+                _net.capacity.set(a, capacity);
+                _changes.push_back(std::make_pair(a, capacity));
+            }
+
+        public:
+            explicit Sweep(Network& net)
+                : Parent(net.graph, net.capacity, net.graph.nodeFromId(0), net.graph.nodeFromId(1)),
+                _net(net), _settled(net.nodeNum(), 0), _lifted_flag(net.nodeNum(), 0),
+                _param_pos(net.nodeNum(), -1), _started(false), _scan(false) {
+                this->globalRelabelFrequency(0.5);
+                _settled[0] = 1;
+                for (int v = 2; v < net.nodeNum(); v++) {
+                    if (net.source_arc[v] != INVALID || net.target_arc[v] != INVALID) {
+                        _param_pos[v] = int(_param.size());
+                        _param.push_back(v);
+                    }
+                }
+            }
+
+            // set the capacities at lambda, the first call starts from the
+            // zero flow, later ones keep the preflow and the labels and only
+            // update the arcs of the terminals of the unsettled nodes
+            void setLambda(Real lambda) {
+                if (!_started) {
+                    _started = true;
+                    for (ListDigraph::ArcIt a(_net.graph); a != INVALID; ++a)
+                        _net.capacity.set(a, _net.line[a](lambda));
+                    this->init();
+                    this->_elevator->logLifted(true);
+                    _scan = true;
+                    return;
+                }
+                _changes.clear();
+                for (int v : _param) {
+                    if (_net.source_arc[v] != INVALID)
+                        setCapacity(_net.source_arc[v], lambda);
+                    if (_net.target_arc[v] != INVALID)
+                        setCapacity(_net.target_arc[v], lambda);
+                }
+                this->updateCapacities(_changes);
+            }
+            // first phase, then collect the nodes lifted to maxLevel()
+            void run() {
+                this->startFirstPhase();
+                if (_scan) {
+                    _scan = false;
+                    for (int v = 2; v < _net.nodeNum(); v++)
+                        addLifted(v);
+                }
+                else {
+                    for (int v : this->_elevator->lifted())
+                        addLifted(v);
+                }
+                this->_elevator->clearLifted();
+            }
+            // nodes lifted since the last settle()
+            const std::vector<int>& lifted() const { return _lifted; }
+            bool settled(int v) const { return _settled[v] != 0; }
+            bool lifted(int v) const { return _lifted_flag[v] != 0; }
+            void settle() {
+                for (int v : _lifted) {
+                    _settled[v] = 1;
+                    _lifted_flag[v] = 0;
+                    removeParam(v);
+                }
+                _lifted.clear();
+            }
+        };
+
+        // network left to a sweep of the interval (lo, hi)
+        struct Task {
+            std::unique_ptr<Network> network;
+            Real lo, hi;
+            Line left, right;
+        };
+
+        const Digraph& _graph;
+        const CAP& _capacity;
+        const CAP& _slope;
+        Node _source, _target;
+        Tolerance<Real> _tolerance;
+        // smallest solved lambda with the node on the source side
+        typename Digraph::template NodeMap<Real> _enter;
+        Real _lambda_min, _lambda_max;
+        std::vector<Breakpoint> _breakpoints;
+        // cut line of each interval between the breakpoints
+        std::vector<Line> _lines;
+        // lambdas which ended a step of a sweep, with the line after them
+        std::vector<Breakpoint> _candidates;
+        std::vector<Task> _tasks;
+        std::vector<int> _index;
+        int _flow_num;
+        int _sweep_num;
+
+        bool sameSlope(const Line& l, const Line& r) const {
+            return !_tolerance.different(l.b, r.b);
+        }
+
+        // change of the cut line when the lifted nodes join the settled ones,
+        // only their arcs are read
+        static Line liftedLine(const Network& net, const Sweep& sweep) {
+            const ListDigraph& g = net.graph;
+            Line l = { 0, 0 };
+            for (int v : sweep.lifted()) {
+                for (ListDigraph::OutArcIt a(g, g.nodeFromId(v)); a != INVALID; ++a) {
+                    int w = g.id(g.target(a));
+                    if (!sweep.settled(w) && !sweep.lifted(w))
+                        l.add(net.line[a]);
+                }
+                for (ListDigraph::InArcIt a(g, g.nodeFromId(v)); a != INVALID; ++a) {
+                    if (sweep.settled(g.id(g.source(a))))
+                        l.subtract(net.line[a]);
+                }
+            }
+            return l;
+        }
+        // network of the lifted nodes, the settled nodes are its source and
+        // the others its target
+        std::unique_ptr<Network> liftedNetwork(const Network& net, const Sweep& sweep) {
+            const ListDigraph& g = net.graph;
+            const std::vector<int>& lifted = sweep.lifted();
+            if (int(_index.size()) < net.nodeNum())
+                _index.resize(net.nodeNum(), -1);
+            std::unique_ptr<Network> sub(new Network);
+            sub->node.resize(2 + lifted.size());
+            for (std::size_t i = 0; i < lifted.size(); i++) {
+                _index[lifted[i]] = int(i) + 2;
+                sub->node[i + 2] = net.node[lifted[i]];
+            }
+            std::vector<NetworkArc> arcs;
+            for (int v : lifted) {
+                for (ListDigraph::OutArcIt a(g, g.nodeFromId(v)); a != INVALID; ++a) {
+                    int w = g.id(g.target(a));
+                    if (sweep.lifted(w)) {
+                        NetworkArc e = { _index[v], _index[w], net.line[a] };
+                        arcs.push_back(e);
+                    }
+                    else if (!sweep.settled(w)) {
+                        NetworkArc e = { _index[v], 1, net.line[a] };
+                        arcs.push_back(e);
+                    }
+                }
+                for (ListDigraph::InArcIt a(g, g.nodeFromId(v)); a != INVALID; ++a) {
+                    if (sweep.settled(g.id(g.source(a)))) {
+                        NetworkArc e = { 0, _index[v], net.line[a] };
+                        arcs.push_back(e);
+                    }
+                }
+            }
+            for (int v : lifted)
+                _index[v] = -1;
+            sub->build(arcs);
+            return sub;
+        }
+        void enter(const Node& node, Real lambda) {
+            if (lambda < _enter[node])
+                _enter.set(node, lambda);
+        }
+
+        // sweep lambda upwards from lo, left is the cut line of the settled
+        // nodes, optimal at lo, right the line of a cut optimal at hi with
+        // the source side right_side, all nodes if it is NULL
+        void sweep(const Network& net, Sweep& solver, Real lo, Real hi, Line left, Line right,
+            const std::vector<int>* right_side) {
+            while (!sameSlope(left, right)) {
+                Real x = Real(right.a - left.a) / Real(left.b - right.b);
+                if (!(x < hi))
+                    break;
+                // the lines meet at lo if the settled nodes are not the largest
+                // source side there
+                bool tie = !(x > lo);
+                Line mid = left;
+                if (tie)
+                    x = lo;
+                else {
+                    solver.setLambda(x);
+                    solver.run();
+                    _flow_num++;
+                    mid.add(liftedLine(net, solver));
+                    tie = solver.lifted().empty() || !_tolerance.less(mid(x), left(x));
+                }
+                if (tie) {
+                    // both lines are optimal at x, left is optimal on [lo, x]
+                    // and right on [x, hi]
+                    Breakpoint bp = { x, right };
+                    _candidates.push_back(bp);
+                    if (right_side) {
+                        for (int v : *right_side) {
+                            if (!solver.settled(v))
+                                enter(net.node[v], x);
+                        }
+                    }
+                    else {
+                        for (int v = 2; v < net.nodeNum(); v++) {
+                            if (!solver.settled(v))
+                                enter(net.node[v], x);
+                        }
+                    }
+                    return;
+                }
+                Task task = { liftedNetwork(net, solver), lo, x, left, mid };
+                _tasks.push_back(std::move(task));
+                for (int v : solver.lifted())
+                    enter(net.node[v], x);
+                solver.settle();
+                Breakpoint bp = { x, mid };
+                _candidates.push_back(bp);
+                lo = x;
+                left = mid;
+            }
+        }
+
+    public:
+        ParametricPreflow(const Digraph& digraph, const CAP& capacity, const CAP& slope,
+            Node source, Node target)
+            : _graph(digraph), _capacity(capacity), _slope(slope),
+            _source(source), _target(target), _enter(digraph),
+            _lambda_min(0), _lambda_max(0), _flow_num(0), _sweep_num(0) {}
+
+        // find the breakpoints of the minimum cut value on [lambda_min, lambda_max]
+        void run(Real lambda_min, Real lambda_max) {
+            if (lambda_min > lambda_max)
+                throw std::invalid_argument("ParametricPreflow: lambda_min exceeds lambda_max");
+            for (ArcIt e(_graph); e != INVALID; ++e) {
+                Node u = _graph.source(e), v = _graph.target(e);
+                Value slope = _slope[e];
+                bool valid = slope == 0;
+                if (u == _source && v != _target)
+                    valid = slope >= 0;
+                else if (v == _target && u != _source)
+                    valid = slope <= 0;
+                if (!valid)
+                    throw std::invalid_argument("ParametricPreflow: the slope of an arc has the wrong sign");
+                if (_capacity[e] + lambda_min * slope < 0 || _capacity[e] + lambda_max * slope < 0)
+                    throw std::invalid_argument("ParametricPreflow: a capacity is negative on the interval");
+            }
+            _lambda_min = lambda_min;
+            _lambda_max = lambda_max;
+            _breakpoints.clear();
+            _lines.clear();
+            _candidates.clear();
+            _flow_num = 0;
+            _sweep_num = 0;
+            for (NodeIt n(_graph); n != INVALID; ++n)
+                _enter.set(n, std::numeric_limits<Real>::infinity());
+            _enter.set(_source, lambda_min);
+
+            Network net;
+            typename Digraph::template NodeMap<int> index(_graph);
+            net.node.resize(2);
+            net.node[0] = _source;
+            net.node[1] = _target;
+            for (NodeIt n(_graph); n != INVALID; ++n) {
+                if (n == _source || n == _target) {
+                    index[n] = n == _source ? 0 : 1;
+                    continue;
+                }
+                index[n] = int(net.node.size());
+                net.node.push_back(n);
+            }
+            std::vector<NetworkArc> arcs;
+            // the cut of the source alone
+            Line base = { 0, 0 };
+            for (ArcIt e(_graph); e != INVALID; ++e) {
+                NetworkArc a = { index[_graph.source(e)], index[_graph.target(e)],
+                    { _capacity[e], _slope[e] } };
+                arcs.push_back(a);
+                if (a.source == 0 && a.target != 0)
+                    base.add(a.capacity);
+            }
+            net.build(arcs);
+
+            Sweep first_sweep(net);
+            first_sweep.setLambda(lambda_min);
+            first_sweep.run();
+            Line first = base;
+            first.add(liftedLine(net, first_sweep));
+            for (int v : first_sweep.lifted())
+                enter(net.node[v], lambda_min);
+            first_sweep.settle();
+            Line last = first;
+            std::vector<int> last_side;
+            _flow_num++;
+            _sweep_num++;
+            if (lambda_max > lambda_min) {
+                Sweep last_sweep(net);
+                last_sweep.setLambda(lambda_max);
+                last_sweep.run();
+                last = base;
+                last.add(liftedLine(net, last_sweep));
+                last_side = last_sweep.lifted();
+                _flow_num++;
+                _sweep_num++;
+            }
+            sweep(net, first_sweep, lambda_min, lambda_max, first, last, &last_side);
+            while (!_tasks.empty()) {
+                Task task = std::move(_tasks.back());
+                _tasks.pop_back();
+                Sweep sub(*task.network);
+                _sweep_num++;
+                sweep(*task.network, sub, task.lo, task.hi, task.left, task.right, NULL);
+            }
+
+            std::sort(_candidates.begin(), _candidates.end());
+            _lines.push_back(first);
+            for (std::size_t i = 0; i < _candidates.size(); i++) {
+                const Breakpoint& bp = _candidates[i];
+                // of the lines optimal at a lambda the one of least slope
+                // holds after it, it is sorted last
+                if (i + 1 < _candidates.size() && _candidates[i + 1].lambda == bp.lambda)
+                    continue;
+                if (bp.lambda <= lambda_min) {
+                    if (bp.right.b < _lines[0].b)
+                        _lines[0] = bp.right;
+                    continue;
+                }
+                if (sameSlope(bp.right, _lines.back()))
+                    continue;
+                _breakpoints.push_back(bp);
+                _lines.push_back(bp.right);
+            }
+        }
+
+        int breakpointNum() const {
+            return int(_breakpoints.size());
+        }
+        Real breakpoint(int i) const {
+            return _breakpoints[i].lambda;
+        }
+        // number of lambdas solved by the last run(), all but the first one
+        // of a sweep start from the preflow of the one before
+        int flowNum() const {
+            return _flow_num;
+        }
+        // number of sweeps of the last run(), each one starts from the zero flow
+        int sweepNum() const {
+            return _sweep_num;
+        }
+        // the node is on the source side of the minimum cut of interval i,
+        // interval 0 starts at lambda_min and interval i > 0 at breakpoint(i - 1)
+        bool minCut(const Node& node, int i) const {
+            return _enter[node] <= (i == 0 ? _lambda_min : _breakpoints[i - 1].lambda);
+        }
+        Real minCutValue(Real lambda) const {
+            int i = 0;
+            while (i < breakpointNum() && _breakpoints[i].lambda <= lambda)
+                i++;
+            return _lines[i](lambda);
+        }
+    };
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <utility>
+namespace lemon {
+    // per-run scratch memory of the push-relabel solvers. The buffers only
+    // grow, so once a solve of some size has run, solves up to that size do
+    // not allocate. Every solver has its own, solvers used one at a time
+    // (e.g. one per rule on the same thread) can share one, see arena().
+    struct PreflowArena {
+        // breadth-first search order of the label searches, finishing
+        // order of returnExcess()
+        std::vector<int> queue;
+        // nodes found by the label searches, the search state of returnExcess()
+        std::vector<char> reached;
+        // depth-first search of returnExcess(), path and next arc per node
+        std::vector<int> stack;
+        std::vector<int> dfs_arc;
+        // updateCapacities: (tail, residual arc) pairs to check against the
+        // labels, and nodes with negative excess
+        std::vector<std::pair<int, int> > update_arcs;
+        std::vector<int> deficit_nodes;
+    };
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <vector>
+#include "cache_aligned.h"
+#ifdef OPENMP
+#include <omp.h>
+#endif
+namespace lemon {
+    // operation counts of a push-relabel run
+    struct PreflowCounters {
+        long long saturating_pushes = 0;
+        long long nonsaturating_pushes = 0;
+        // pushes along a reverse residual arc, which return flow
+        long long push_backs = 0;
+        long long relabels = 0;
+        long long discharges = 0;
+        long long gaps = 0;
+        long long global_relabels = 0;
+        // rounds of Preflow_Parallel and the active nodes of each round
+        long long rounds = 0;
+        std::vector<int> active_per_round;
+
+        PreflowCounters& operator+=(const PreflowCounters& c) {
+            saturating_pushes += c.saturating_pushes;
+            nonsaturating_pushes += c.nonsaturating_pushes;
+            push_backs += c.push_backs;
+            relabels += c.relabels;
+            discharges += c.discharges;
+            gaps += c.gaps;
+            global_relabels += c.global_relabels;
+            rounds += c.rounds;
+            active_per_round.insert(active_per_round.end(),
+                c.active_per_round.begin(), c.active_per_round.end());
+            return *this;
+        }
+    };
+
+    // statistics policy of the traits which counts nothing, all calls are
+    // empty inline functions and vanish from the hot path
+    struct NoPreflowStatistics {
+        static const bool enabled = false;
+        void clear() {}
+        void push(bool, bool, int = 0) {}
+        void relabel(int = 0) {}
+        void discharge(int = 0) {}
+        void gap() {}
+        void globalRelabel() {}
+        void round(int) {}
+        PreflowCounters counters() const { return PreflowCounters(); }
+    };
+
+    // statistics policy which counts, the parallel solvers count in one slot
+    // per thread and counters() sums them
+    class PreflowStatistics {
+        struct Slot {
+            PreflowCounters c;
+        };
+        // slots on cache lines of their own, threads do not share lines
+        CacheAlignedArray<Slot> _slots;
+    public:
+        static const bool enabled = true;
+        PreflowStatistics() {
+            clear();
+        }
+        void clear() {
+#if OPENMP
+            _slots.assign(omp_get_max_threads());
+#else
+            _slots.assign(1);
+#endif
+        }
+        void push(bool saturating, bool push_back, int thread_id = 0) {
+            PreflowCounters& c = _slots[thread_id].c;
+            if (saturating)
+                c.saturating_pushes++;
+            else
+                c.nonsaturating_pushes++;
+            if (push_back)
+                c.push_backs++;
+        }
+        void relabel(int thread_id = 0) {
+            _slots[thread_id].c.relabels++;
+        }
+        void discharge(int thread_id = 0) {
+            _slots[thread_id].c.discharges++;
+        }
+        void gap() {
+            _slots[0].c.gaps++;
+        }
+        void globalRelabel() {
+            _slots[0].c.global_relabels++;
+        }
+        void round(int active_num) {
+            _slots[0].c.rounds++;
+            _slots[0].c.active_per_round.push_back(active_num);
+        }
+        PreflowCounters counters() const {
+            PreflowCounters sum;
+            for (int t = 0; t < _slots.size(); t++)
+                sum += _slots[t].c;
+            return sum;
+        }
+    };
+
+    // traits TR with the counting statistics policy, e.g.
+    // Preflow_HL<GR, CAP, PreflowStatisticsTraits<Preflow_HLDefaultTraits<GR, CAP> > >
+    template <typename TR>
+    struct PreflowStatisticsTraits : public TR {
+        typedef PreflowStatistics Statistics;
+    };
+}
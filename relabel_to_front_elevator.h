@@ -1,101 +1,170 @@
-#include <list>
+#include <vector>
+#include <algorithm>
+#include "node_state.h"
 
 namespace lemon{
-    template<class GR, class Item>
+    template<class GR, class Item, class State = PackedNodeState<int> >
     class RelabelElevator{
         //relabel to front elevator
-        
+
     public:
         typedef int Value;
-        typedef typename std::list<Item>::iterator iterator; 
 		typedef typename GR::NodeIt NodeIt;
+        typedef State NodeState;
+
+        // iterator over the relabel-to-front order, it stays valid when
+        // its item is moved to the front
+        class iterator {
+            const RelabelElevator* _ele;
+            int _id;
+            friend class RelabelElevator;
+        public:
+            iterator() : _ele(NULL), _id(-1) {}
+            iterator(const RelabelElevator* ele, int id) : _ele(ele), _id(id) {}
+            Item operator*() const { return _ele->_graph->nodeFromId(_id); }
+            iterator& operator++() {
+                _id = _ele->_next[_id];
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator it(*this);
+                _id = _ele->_next[_id];
+                return it;
+            }
+            bool operator==(const iterator& it) const { return _id == it._id; }
+            bool operator!=(const iterator& it) const { return _id != it._id; }
+        };
     private:
-        typedef typename ItemSetTraits<GR, Item>::
-        template Map<int>::Type IntMap;
-        typedef typename ItemSetTraits<GR, Item>::
-        template Map<bool>::Type BoolMap;
-        
-        const GR &_graph;
+        const GR* _graph;
         int _max_level;
-        IntMap _level;
-        BoolMap _active;
-        std::list<Item> relabel_list;
+        // all state is kept in arrays indexed by item id, so a copy of the
+        // elevator copies a few contiguous blocks, the labels are in the
+        // node state shared with the solver
+        State _state;
+        std::vector<char> _active;
+        // relabel-to-front order as a doubly linked list, -1 ends the list
+        std::vector<int> _prev, _next;
+        int _first = -1;
+        int _last = -1;
+
+        void pushFront(int id) {
+            _prev[id] = -1;
+            _next[id] = _first;
+            if (_first != -1)
+                _prev[_first] = id;
+            else
+                _last = id;
+            _first = id;
+        }
+        void pushBack(int id) {
+            _next[id] = -1;
+            _prev[id] = _last;
+            if (_last != -1)
+                _next[_last] = id;
+            else
+                _first = id;
+            _last = id;
+        }
+        void unlink(int id) {
+            if (_prev[id] != -1)
+                _next[_prev[id]] = _next[id];
+            else
+                _first = _next[id];
+            if (_next[id] != -1)
+                _prev[_next[id]] = _prev[id];
+            else
+                _last = _prev[id];
+        }
 
     public:
-        RelabelElevator(const GR& graph, int max_level)
-        : _graph(graph), _max_level(max_level),
-          _level(graph), _active(graph), _init_level(0){}
-        
-		RelabelElevator(const RelabelElevator& ele): 
-			_graph(ele._graph), _max_level(ele._max_level),relabel_list(ele.relabel_list),
-			_level(ele._graph), _active(ele._graph){
-			for (NodeIt n(_graph); n != INVALID; ++n) {
-				_level[n] = ele._level[n];
-			}
-			// no need to copy the active nodemap
-		}
+        RelabelElevator(const GR& graph, int max_level) : _init_level(0){
+            reset(graph, max_level);
+        }
+
+        // rebind to a graph, the arrays keep their memory if it suffices
+        void reset(const GR& graph, int max_level) {
+            int item_num = graph.maxNodeId() + 1;
+            _graph = &graph;
+            _max_level = max_level;
+            _state.resize(item_num);
+            _active.assign(item_num, 0);
+            _prev.assign(item_num, -1);
+            _next.assign(item_num, -1);
+            _first = _last = -1;
+        }
+
+		RelabelElevator(const RelabelElevator& ele) = default;
 
         void activate(Item i) {
-            _active[i] = true;
+            _active[_graph->id(i)] = 1;
         }
-        
+
         void deactivate(Item i) {
-            _active[i] = false;
+            _active[_graph->id(i)] = 0;
         }
-        
-        bool active(Item i) const { return _active[i]; }
-        
-        int operator[](Item i) const { return _level[i]; }
+
+        bool active(Item i) const { return _active[_graph->id(i)] != 0; }
+
+        int operator[](Item i) const { return _state.level(_graph->id(i)); }
 
         void lift(Item i, int new_level) {
-            _level[i] = new_level;
+            _state.level(_graph->id(i)) = new_level;
         }
 
         int maxLevel() const {
             return _max_level;
         }
+        // label, excess and current arc of the items, shared with the solver
+        State& nodeState() {
+            return _state;
+        }
 
-        // move the Item to the front of relabel_list
+        // move the Item to the front of the relabel order
         void moveToFront(iterator item_it) {
-            Item item = *item_it;
-            relabel_list.erase(item_it);
-            relabel_list.push_front(item);
+            if (item_it._id == _first)
+                return;
+            unlink(item_it._id);
+            pushFront(item_it._id);
+        }
+        iterator begin() const {
+            return iterator(this, _first);
         }
-        iterator begin() {
-            return relabel_list.begin();
+        iterator end() const {
+            return iterator(this, -1);
         }
-        iterator end() {
-            return relabel_list.end();
-        }    
     private:
-        
+
         int _init_level = 0;
-    
+
     public:
-        
+
         void initStart() {
-            for(typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+            for(typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                _level[i] = -1;
-                _active[i] = false;
+                _state.level(_graph->id(i)) = -1;
             }
+            std::fill(_active.begin(), _active.end(), 0);
+            _first = _last = -1;
+            _init_level = 0;
         }
         void initAddItem(Item i) {
-            _level[i] = _init_level;
-            relabel_list.push_front(i);
+            int id = _graph->id(i);
+            _state.level(id) = _init_level;
+            pushFront(id);
         }
         void initNewLevel() {
             ++_init_level;
         }
-        void initFinish() {            
-            for (typename ItemSetTraits<GR, Item>::ItemIt i(_graph);
+        void initFinish() {
+            for (typename ItemSetTraits<GR, Item>::ItemIt i(*_graph);
                 i != INVALID; ++i) {
-                if (_level[i] == -1) {
-                    relabel_list.push_back(i);
-                    _level[i] = _max_level;
+                int id = _graph->id(i);
+                if (_state.level(id) == -1) {
+                    pushBack(id);
+                    _state.level(id) = _max_level;
                 }
             }
 
         }
     };
-}
\ No newline at end of file
+}
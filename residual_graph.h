@@ -0,0 +1,185 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <lemon/core.h>
+
+namespace lemon {
+    // compressed sparse row (CSR) residual graph of a LEMON digraph.
+    // Nodes and arcs are addressed by the ids of the original digraph.
+    // The residual arcs leaving a node are stored contiguously, first the
+    // forward arcs (original out arcs), then the reverse arcs (original in arcs),
+    // and each residual arc knows its paired arc in the opposite direction.
+    // Residual capacities of all residual arcs live in one contiguous array.
+    // The arc structure is immutable once built and can be shared by several
+    // residual graphs of the same digraph, see share().
+    template <typename GR, typename V>
+    class ResidualGraph {
+    public:
+        typedef GR Digraph;
+        typedef V Value;
+        typedef typename Digraph::Node Node;
+        typedef typename Digraph::Arc Arc;
+    private:
+        typedef typename Digraph::NodeIt NodeIt;
+        typedef typename Digraph::ArcIt ArcIt;
+        typedef typename Digraph::OutArcIt OutArcIt;
+        typedef typename Digraph::InArcIt InArcIt;
+
+        struct Topology {
+            std::vector<int> first_out; // node id -> first residual arc, the last entry is the arc number
+            std::vector<int> head;      // residual arc -> head node id
+            std::vector<int> pair;      // residual arc -> residual arc in the opposite direction
+            std::vector<int> arc_ref;   // residual arc -> 2 * original arc id, +1 for reverse arcs
+            std::vector<int> forward;   // original arc id -> forward residual arc
+        };
+
+        int _node_num;
+        int _arc_num;
+        // not shared with another residual graph, build() reuses it then
+        std::shared_ptr<Topology> _topology;
+        // the arrays of _topology
+        const int* _first_out;
+        const int* _head;
+        const int* _pair;
+        const int* _arc_ref;
+        const int* _forward;
+        std::vector<Value> _residual;
+        // scratch space of build()
+        std::vector<int> _backward;
+
+        void attach(const std::shared_ptr<Topology>& topology) {
+            _topology = topology;
+            _node_num = int(topology->first_out.size()) - 1;
+            _arc_num = topology->first_out.back();
+            _first_out = topology->first_out.data();
+            _head = topology->head.data();
+            _pair = topology->pair.data();
+            _arc_ref = topology->arc_ref.data();
+            _forward = topology->forward.data();
+            _residual.resize(_arc_num);
+        }
+
+    public:
+        ResidualGraph() : _node_num(0), _arc_num(0), _first_out(NULL), _head(NULL),
+            _pair(NULL), _arc_ref(NULL), _forward(NULL) {}
+        ResidualGraph(const ResidualGraph& res) : ResidualGraph() {
+            *this = res;
+        }
+        ResidualGraph& operator=(const ResidualGraph& res) {
+            if (res.built())
+                attach(res._topology);
+            _residual = res._residual;
+            return *this;
+        }
+
+        // build the residual structure, residual capacities are left undefined.
+        // The arrays of an earlier build are reused unless they are shared.
+        void build(const Digraph& digraph) {
+            std::shared_ptr<Topology> topology;
+            if (_topology && _topology.use_count() == 1)
+                topology = _topology;
+            else
+                topology.reset(new Topology);
+            int node_num = digraph.maxNodeId() + 1;
+            int arc_id_num = digraph.maxArcId() + 1;
+            std::vector<int>& _first_out = topology->first_out;
+            std::vector<int>& _head = topology->head;
+            std::vector<int>& _pair = topology->pair;
+            std::vector<int>& _arc_ref = topology->arc_ref;
+            std::vector<int>& _forward = topology->forward;
+            _first_out.assign(node_num + 1, 0);
+            for (ArcIt e(digraph); e != INVALID; ++e) {
+                _first_out[digraph.id(digraph.source(e)) + 1]++;
+                _first_out[digraph.id(digraph.target(e)) + 1]++;
+            }
+            for (int i = 0; i < node_num; i++) {
+                _first_out[i + 1] += _first_out[i];
+            }
+            int arc_num = _first_out[node_num];
+            _head.resize(arc_num);
+            _pair.resize(arc_num);
+            _arc_ref.resize(arc_num);
+            _forward.assign(arc_id_num, -1);
+            std::vector<int>& backward = _backward;
+            backward.assign(arc_id_num, -1);
+            for (NodeIt n(digraph); n != INVALID; ++n) {
+                int pos = _first_out[digraph.id(n)];
+                for (OutArcIt e(digraph, n); e != INVALID; ++e) {
+                    int id = digraph.id(e);
+                    _head[pos] = digraph.id(digraph.target(e));
+                    _arc_ref[pos] = 2 * id;
+                    _forward[id] = pos++;
+                }
+                for (InArcIt e(digraph, n); e != INVALID; ++e) {
+                    int id = digraph.id(e);
+                    _head[pos] = digraph.id(digraph.source(e));
+                    _arc_ref[pos] = 2 * id + 1;
+                    backward[id] = pos++;
+                }
+            }
+            for (int id = 0; id < arc_id_num; id++) {
+                if (_forward[id] < 0)
+                    continue;
+                _pair[_forward[id]] = backward[id];
+                _pair[backward[id]] = _forward[id];
+            }
+            attach(topology);
+        }
+        // use the arc structure of res, which has been built for the same
+        // digraph, residual capacities are left undefined
+        void share(const ResidualGraph& res) {
+            attach(res._topology);
+        }
+
+        bool built() const {
+            return _topology.get() != NULL;
+        }
+
+        // reset to the zero flow
+        template <typename CAP>
+        void setCapacity(const Digraph& digraph, const CAP& capacity) {
+            for (ArcIt e(digraph); e != INVALID; ++e) {
+                setArc(digraph.id(e), capacity[e], 0);
+            }
+        }
+
+        template <typename CAP, typename FM>
+        void setFlow(const Digraph& digraph, const CAP& capacity, const FM& flow) {
+            for (ArcIt e(digraph); e != INVALID; ++e) {
+                setArc(digraph.id(e), capacity[e], flow[e]);
+            }
+        }
+
+        int nodeNum() const { return _node_num; }
+        int arcNum() const { return _arc_num; }
+
+        int outBegin(int n) const { return _first_out[n]; }
+        int outEnd(int n) const { return _first_out[n + 1]; }
+
+        int target(int a) const { return _head[a]; }
+        int pair(int a) const { return _pair[a]; }
+        bool forward(int a) const { return (_arc_ref[a] & 1) == 0; }
+        // id of the original arc the residual arc a belongs to
+        int arcId(int a) const { return _arc_ref[a] >> 1; }
+        // forward residual arc of the original arc with the given id
+        int forwardArc(int arc_id) const { return _forward[arc_id]; }
+
+        Value& residual(int a) { return _residual[a]; }
+        const Value& residual(int a) const { return _residual[a]; }
+
+        // send d units of flow along the residual arc a
+        void augment(int a, Value d) {
+            _residual[a] -= d;
+            _residual[_pair[a]] += d;
+        }
+
+        Value flow(int arc_id) const {
+            return _residual[_pair[_forward[arc_id]]];
+        }
+        void setArc(int arc_id, Value capacity, Value flow) {
+            int a = _forward[arc_id];
+            _residual[a] = capacity - flow;
+            _residual[_pair[a]] = flow;
+        }
+    };
+}
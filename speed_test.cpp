@@ -7,12 +7,14 @@
 #include <chrono>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 #include <exception>
 
 #include <boost/program_options.hpp>
 #include <lemon/list_graph.h>
 #include <lemon/preflow.h>
 #include "mf_base.h"
+#include "parametric_preflow.h"
 
 namespace lemon{
 class ScalableGraph{
@@ -26,9 +28,10 @@ class ScalableGraph{
     typedef Digraph::OutArcIt OutArcIt;
     typedef Digraph::InArcIt InArcIt;
 
-    ScalableGraph(int layer_num, int layer_size, bool verbose = false):
+    ScalableGraph(int layer_num, int layer_size, bool verbose = false,
+                  double global_relabel_freq = 0):
       _layer_num(layer_num), _layer_size(layer_size), _verbose(verbose),
-      aM(_graph), _init_revert(false){}
+      aM(_graph), _init_revert(false), _global_relabel_freq(global_relabel_freq){}
 
     void init(bool isReverted = false) {
         _init_revert = isReverted;
@@ -104,6 +107,29 @@ class ScalableGraph{
         }
         average_time /= _layer_num ;
         report["afterwards"] = average_time;
+
+        // the same family of capacities as one parametric problem, source arcs
+        // gain lambda and target arcs lose lambda, lambda in [0, layer_num]
+        ArcMap param_cap(_graph), param_slope(_graph);
+        for (Digraph::ArcIt arc(_graph); arc != INVALID; ++arc) {
+            param_cap[arc] = aM[arc];
+            param_slope[arc] = 0;
+        }
+        for (OutArcIt arc(_graph, _source); arc != INVALID; ++arc) {
+            param_cap[arc] -= _layer_num;
+            param_slope[arc] = 1;
+        }
+        for (InArcIt arc(_graph, _target); arc != INVALID; ++arc) {
+            param_cap[arc] += _layer_num;
+            param_slope[arc] = -1;
+        }
+        start_time = std::chrono::system_clock::now();
+        ParametricPreflow<Digraph, ArcMap> pp(_graph, param_cap, param_slope, _source, _target);
+        pp.run(0, _layer_num);
+        end_time = std::chrono::system_clock::now();
+        dtn = end_time - start_time;
+        report["breakpoints"] = std::chrono::duration_cast<std::chrono::milliseconds>(dtn).count()/1000.0;
+        assert(std::abs(pp.minCutValue(_layer_num) - _layer_size * (1 + _layer_num)) < 1e-6);
     }
 
     //! run the algorithm with timer support
@@ -115,6 +141,7 @@ class ScalableGraph{
 
         start_time = std::chrono::system_clock::now();
         Preflow_Relabel<Digraph, ArcMap> pf_relabel(_graph, aM, _source, _target);
+        pf_relabel.globalRelabelFrequency(_global_relabel_freq);
         pf_relabel.run();
         end_time = std::chrono::system_clock::now();
         dtn = end_time - start_time;
@@ -126,6 +153,7 @@ class ScalableGraph{
 
         start_time = std::chrono::system_clock::now();
         Preflow_HL<Digraph, ArcMap> pf(_graph, aM, _source, _target);
+        pf.globalRelabelFrequency(_global_relabel_freq);
         pf.run();
         end_time = std::chrono::system_clock::now();
         dtn = end_time - start_time;
@@ -137,6 +165,7 @@ class ScalableGraph{
 
 		start_time = std::chrono::system_clock::now();
 		Preflow_FIFO<Digraph, ArcMap> pf_fifo(_graph, aM, _source, _target);
+		pf_fifo.globalRelabelFrequency(_global_relabel_freq);
 		pf_fifo.run();
 		end_time = std::chrono::system_clock::now();
 		dtn = end_time - start_time;
@@ -165,6 +194,7 @@ class ScalableGraph{
     int _layer_size;
     bool _verbose;
     bool _init_revert;
+    double _global_relabel_freq;
     Digraph _graph;
     ArcMap aM;
     Node _source;
@@ -188,7 +218,8 @@ int main(int argc, const char *argv[]){
         ("help,h", "Show this help screen")
         ("layer_num", boost::program_options::value<int>()->default_value(4)->notifier(check_positive), "the number of layer")
         ("layer_size", boost::program_options::value<int>()->default_value(3)->notifier(check_positive), "the number of nodes per layer")
-        ("parametric", boost::program_options::value<bool>()->implicit_value(true)->default_value(false), "whether to run parametric speed test");
+        ("parametric", boost::program_options::value<bool>()->implicit_value(true)->default_value(false), "whether to run parametric speed test")
+        ("global_relabel", boost::program_options::value<double>()->default_value(0), "frequency of the global relabel heuristic, 0 disables it");
     boost::program_options::variables_map vm;
     boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
     boost::program_options::notify(vm);
@@ -199,7 +230,8 @@ int main(int argc, const char *argv[]){
     int layer_num = vm["layer_num"].as<int>();
     int layer_size = vm["layer_size"].as<int>();
     bool parametric = vm["parametric"].as<bool>();
-    ScalableGraph* sg = new ScalableGraph(layer_num, layer_size);
+    double global_relabel_freq = vm["global_relabel"].as<double>();
+    ScalableGraph* sg = new ScalableGraph(layer_num, layer_size, false, global_relabel_freq);
     sg->init(parametric);
     if(parametric)
         sg->run_parametric();
@@ -1,4 +1,6 @@
 #include <cmath>
+#include <cstdlib>
+#include <atomic>
 #include <gtest/gtest.h>
 #include <lemon/adaptors.h>
 #include <lemon/concepts/digraph.h>
@@ -6,6 +8,13 @@
 #include <lemon/list_graph.h>
 #include <lemon/preflow.h>
 #include "mf_base.h"
+#include "dimacs_io.h"
+#include "mapped_digraph.h"
+#include "parametric_preflow.h"
+#include "batch_preflow.h"
+#include "gomory_hu.h"
+#include "graph_generators.h"
+#include "graph_reorder.h"
 using namespace lemon;
 TEST(Preflow_Relabel, Constructor) {
     typedef concepts::Digraph Digraph;
@@ -53,6 +62,34 @@ TEST(RelabelElevator, MoveToFront) {
     EXPECT_EQ(g.id(*re_it_2), g.id(b));    
 }
 
+TEST(RelabelElevator, CopyOrder) {
+    typedef ListDigraph Digraph;
+    typedef ListDigraph::Node Item;
+    typedef RelabelElevator<Digraph, Item> RelabelElevator;
+    Digraph g;
+    Item a = g.addNode();
+    Item b = g.addNode();
+    Item c = g.addNode();
+    RelabelElevator re(g, 3);
+    re.initStart();
+    re.initAddItem(a);
+    re.initAddItem(b);
+    re.initAddItem(c);
+    re.initFinish();
+    RelabelElevator copy(re);
+    // move the middle item, the copy keeps the old order
+    RelabelElevator::iterator it = re.begin();
+    ++it;
+    re.moveToFront(it);
+    std::vector<int> order, copy_order;
+    for (RelabelElevator::iterator i = re.begin(); i != re.end(); ++i)
+        order.push_back(g.id(*i));
+    for (RelabelElevator::iterator i = copy.begin(); i != copy.end(); ++i)
+        copy_order.push_back(g.id(*i));
+    EXPECT_EQ(order, std::vector<int>({ g.id(b), g.id(c), g.id(a) }));
+    EXPECT_EQ(copy_order, std::vector<int>({ g.id(c), g.id(b), g.id(a) }));
+}
+
 TEST(Preflow_Relabel, Run){
 	// https://en.wikipedia.org/wiki/Push%E2%80%93relabel_maximum_flow_algorithm#Example
     typedef ListDigraph Digraph;
@@ -346,6 +383,40 @@ TEST(FIFOElevator, GetFrontSecondPhase) {
 	EXPECT_TRUE(get_item);
 	EXPECT_EQ(g.id(n1), g.id(c));
 }
+TEST(FIFOElevator, QueuedOnce) {
+	typedef ListDigraph Digraph;
+	typedef ListDigraph::Node Item;
+	typedef FIFOElevator<Digraph, Item> FIFOElevator;
+	Digraph g;
+	Item a = g.addNode();
+	Item b = g.addNode();
+	Item c = g.addNode();
+	FIFOElevator re(g, 3);
+	re.initStart();
+	re.initAddItem(a);
+	re.initAddItem(b);
+	re.initFinish();
+	// c is at the max level and parked in the first phase
+	for (int k = 0; k < 3; k++) {
+		re.activate(c);
+		re.activate(a);
+		re.activate(b);
+	}
+	re.deactivate(b);
+	EXPECT_TRUE(re.active(a));
+	EXPECT_FALSE(re.active(b));
+	Item n1;
+	EXPECT_TRUE(re.getFront(n1, true));
+	EXPECT_EQ(g.id(n1), g.id(a));
+	EXPECT_FALSE(re.active(a));
+	EXPECT_FALSE(re.getFront(n1, true));
+	re.activate(b);
+	EXPECT_TRUE(re.getFront(n1, true));
+	EXPECT_EQ(g.id(n1), g.id(b));
+	EXPECT_TRUE(re.getFront(n1, false));
+	EXPECT_EQ(g.id(n1), g.id(c));
+	EXPECT_FALSE(re.getFront(n1, false));
+}
 TEST(Preflow_FIFO, RUN) {
 	typedef ListDigraph Digraph;
 	typedef int T;
@@ -539,7 +610,14 @@ TEST(ParaElevator, ConcatenateActiveSet) {
 	Item n = g.addNode();
 	ParaElevator pe(g, 2);
 	pe.activate(n);
+	pe.activate(n);
 	pe.concatenate_active_sets();
+	EXPECT_EQ(pe.get_active_count(), 1);
+	EXPECT_TRUE(pe.active(n));
+	pe.clear_discover(n);
+	pe.activate(n);
+	pe.concatenate_active_sets();
+	EXPECT_EQ(pe.get_active_count(), 1);
 }
 
 TEST(Preflow_Parallel, Construction) {
@@ -618,4 +696,1119 @@ TEST(Preflow_Parallel, Floating) {
 	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
 		EXPECT_EQ(pf.minCut(n), pf_para.minCut(n));
 	}
-}
\ No newline at end of file
+}
+TEST(ResidualGraph, Build) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	typedef ListDigraph::Arc Arc;
+	Digraph g;
+	Node n0 = g.addNode();
+	Node n1 = g.addNode();
+	Node n2 = g.addNode();
+	ArcMap aM(g);
+	Arc a1 = g.addArc(n0, n1);
+	Arc a2 = g.addArc(n1, n2);
+	Arc a3 = g.addArc(n0, n2);
+	aM[a1] = 3;
+	aM[a2] = 2;
+	aM[a3] = 1;
+	ResidualGraph<Digraph, T> res;
+	res.build(g);
+	res.setCapacity(g, aM);
+	EXPECT_EQ(res.nodeNum(), 3);
+	EXPECT_EQ(res.arcNum(), 6);
+	EXPECT_EQ(res.outEnd(g.id(n1)) - res.outBegin(g.id(n1)), 2);
+	for (int a = 0; a < res.arcNum(); a++) {
+		EXPECT_EQ(res.pair(res.pair(a)), a);
+		EXPECT_NE(res.forward(a), res.forward(res.pair(a)));
+		EXPECT_EQ(res.arcId(a), res.arcId(res.pair(a)));
+	}
+	int f = res.forwardArc(g.id(a1));
+	EXPECT_EQ(res.target(f), g.id(n1));
+	EXPECT_EQ(res.target(res.pair(f)), g.id(n0));
+	EXPECT_EQ(res.residual(f), 3);
+	res.augment(f, 2);
+	EXPECT_EQ(res.residual(f), 1);
+	EXPECT_EQ(res.flow(g.id(a1)), 2);
+	EXPECT_EQ(res.flow(g.id(a2)), 0);
+}
+
+TEST(Preflow_HL, FlowMap) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	Preflow_HL<Digraph, ArcMap> pf_hl(g, cap, s, t);
+	pf_hl.run();
+	const Preflow_HL<Digraph, ArcMap>::FlowMap& flow = pf_hl.flowMap();
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		T excess = 0;
+		for (Digraph::InArcIt e(g, n); e != INVALID; ++e)
+			excess += flow[e];
+		for (Digraph::OutArcIt e(g, n); e != INVALID; ++e)
+			excess -= flow[e];
+		if (n == t)
+			EXPECT_EQ(excess, pf_hl.flowValue());
+		else if (n != s)
+			EXPECT_EQ(excess, 0);
+	}
+	for (Digraph::ArcIt e(g); e != INVALID; ++e) {
+		EXPECT_LE(flow[e], cap[e]);
+		EXPECT_GE(flow[e], 0);
+		EXPECT_EQ(flow[e], pf_hl.flow(e));
+	}
+}
+
+TEST(Preflow_Relabel, GlobalRelabel) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	Preflow_Relabel<Digraph, ArcMap> pf_relabel(g, cap, s, t);
+	Preflow<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	// relabel globally after every relabel operation
+	pf_relabel.globalRelabelFrequency(100);
+	pf_relabel.init();
+	pf_relabel.startFirstPhase();
+	EXPECT_EQ(pf_relabel.flowValue(), pf.flowValue());
+	pf_relabel.startSecondPhase();
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		if (g.id(n) != 0 && g.id(n) != 7)
+			EXPECT_EQ(pf.minCut(n), pf_relabel.minCut(n));
+	}
+}
+
+TEST(Preflow_FIFO, GlobalRelabel) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	Preflow_FIFO<Digraph, ArcMap> pf_fifo(g, cap, s, t);
+	Preflow<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	pf_fifo.globalRelabelFrequency(100);
+	pf_fifo.init();
+	pf_fifo.startFirstPhase();
+	EXPECT_EQ(pf_fifo.flowValue(), pf.flowValue());
+	pf_fifo.startSecondPhase();
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		if (g.id(n) != 0 && g.id(n) != 7)
+			EXPECT_EQ(pf.minCut(n), pf_fifo.minCut(n));
+	}
+}
+
+TEST(Preflow_HL, GlobalRelabel) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	Preflow_HL<Digraph, ArcMap> pf_hl(g, cap, s, t);
+	Preflow<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	pf_hl.globalRelabelFrequency(100);
+	pf_hl.init();
+	pf_hl.startFirstPhase();
+	EXPECT_EQ(pf_hl.flowValue(), pf.flowValue());
+	pf_hl.startSecondPhase();
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		if (g.id(n) != 0 && g.id(n) != 7)
+			EXPECT_EQ(pf.minCut(n), pf_hl.minCut(n));
+	}
+}
+
+TEST(HLElevator, Gap) {
+    typedef ListDigraph Digraph;
+    typedef ListDigraph::Node Item;
+    typedef HLElevator<Digraph, Item> HLElevator;
+    Digraph g;
+    Item a = g.addNode();
+    Item b = g.addNode();
+    Item c = g.addNode();
+    HLElevator re(g, 4);
+    re.initStart();
+    re.initAddItem(a);
+    re.initNewLevel();
+    re.initAddItem(b);
+    re.initNewLevel();
+    re.initAddItem(c);
+    re.initFinish();
+    EXPECT_EQ(re.levelCount(1), 1);
+    re.activate(c);
+    re.lift(b, 3);
+    EXPECT_TRUE(re.emptyLevel(1));
+    re.liftToTop(2);
+    EXPECT_EQ(re[a], 0);
+    EXPECT_EQ(re[b], 4);
+    EXPECT_EQ(re[c], 4);
+    EXPECT_EQ(re.levelCount(4), 2);
+    Item n1;
+    EXPECT_FALSE(re.get_node_with_highest_label(n1, true));
+    EXPECT_TRUE(re.get_node_with_highest_label(n1, false));
+    EXPECT_EQ(g.id(n1), g.id(c));
+}
+TEST(HLElevator, LogLifted) {
+    typedef ListDigraph Digraph;
+    typedef ListDigraph::Node Item;
+    typedef HLElevator<Digraph, Item> HLElevator;
+    Digraph g;
+    Item a = g.addNode();
+    Item b = g.addNode();
+    Item c = g.addNode();
+    HLElevator re(g, 4);
+    re.initStart();
+    re.initAddItem(a);
+    re.initNewLevel();
+    re.initAddItem(b);
+    re.initNewLevel();
+    re.initAddItem(c);
+    re.initFinish();
+    EXPECT_TRUE(re.lifted().empty());
+    re.logLifted(true);
+    re.lift(b, 3);
+    EXPECT_TRUE(re.lifted().empty());
+    re.lift(a, 5);
+    re.liftToTop(2);
+    // a by lift(), b and c by the gap
+    std::vector<int> lifted = re.lifted();
+    std::sort(lifted.begin(), lifted.end());
+    EXPECT_EQ(lifted, std::vector<int>({ g.id(a), g.id(b), g.id(c) }));
+    re.clearLifted();
+    EXPECT_TRUE(re.lifted().empty());
+}
+TEST(HLElevator, ActiveBuckets) {
+    typedef ListDigraph Digraph;
+    typedef ListDigraph::Node Item;
+    typedef HLElevator<Digraph, Item> HLElevator;
+    Digraph g;
+    Item a = g.addNode();
+    Item b = g.addNode();
+    Item c = g.addNode();
+    HLElevator re(g, 4);
+    re.initStart();
+    re.initAddItem(a);
+    re.initAddItem(b);
+    re.initNewLevel();
+    re.initAddItem(c);
+    re.initFinish();
+    re.activate(a);
+    re.activate(a);
+    re.activate(b);
+    re.activate(c);
+    EXPECT_TRUE(re.active(a));
+    re.deactivate(c);
+    EXPECT_FALSE(re.active(c));
+    // an active item moves with its label
+    re.lift(b, 2);
+    Item n1;
+    EXPECT_TRUE(re.get_node_with_highest_label(n1));
+    EXPECT_EQ(g.id(n1), g.id(b));
+    EXPECT_FALSE(re.active(b));
+    EXPECT_TRUE(re.get_node_with_highest_label(n1));
+    EXPECT_EQ(g.id(n1), g.id(a));
+    // a is queued once only
+    EXPECT_FALSE(re.get_node_with_highest_label(n1));
+}
+
+TEST(Preflow_Base, CurrentArcDense) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Node> nodes;
+	for (int i = 0; i < 30; i++)
+		nodes.push_back(g.addNode());
+	for (int i = 0; i < 30; i++)
+		for (int j = 0; j < 30; j++)
+			if (i != j)
+				cap[g.addArc(nodes[i], nodes[j])] = (i * 7 + j * 13) % 10;
+	Node s = nodes[0], t = nodes[29];
+	Preflow<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	Preflow_Relabel<Digraph, ArcMap> pf_rtf(g, cap, s, t);
+	pf_rtf.run();
+	EXPECT_EQ(pf_rtf.flowValue(), pf.flowValue());
+	Preflow_FIFO<Digraph, ArcMap> pf_fifo(g, cap, s, t);
+	pf_fifo.run();
+	EXPECT_EQ(pf_fifo.flowValue(), pf.flowValue());
+	Preflow_HL<Digraph, ArcMap> pf_hl(g, cap, s, t);
+	pf_hl.run();
+	EXPECT_EQ(pf_hl.flowValue(), pf.flowValue());
+	Preflow_Parallel<Digraph, ArcMap> pf_pa(g, cap, s, t);
+	pf_pa.run();
+	EXPECT_EQ(pf_pa.flowValue(), pf.flowValue());
+}
+
+TEST(Dimacs, ReadWrite) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	std::istringstream is(
+		"c small instance\n"
+		"p max 4 5\n"
+		"n 1 s\n"
+		"n 4 t\n"
+		"a 1 2 3\n"
+		"a 1 3 2\n"
+		"\n"
+		"a 2 3 1\n"
+		"a 2 4 2\n"
+		"a 3 4 3\n");
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	readDimacsMaxFlow(is, g, cap, s, t);
+	EXPECT_EQ(countNodes(g), 4);
+	EXPECT_EQ(countArcs(g), 5);
+	Preflow_HL<Digraph, ArcMap> pf_hl(g, cap, s, t);
+	pf_hl.run();
+	EXPECT_EQ(pf_hl.flowValue(), 5);
+
+	std::stringstream ss;
+	writeDimacsMaxFlow(ss, g, cap, s, t);
+	Digraph g2;
+	ArcMap cap2(g2);
+	Node s2, t2;
+	readDimacsMaxFlow(ss, g2, cap2, s2, t2);
+	EXPECT_EQ(countArcs(g2), 5);
+	Preflow_HL<Digraph, ArcMap> pf_hl2(g2, cap2, s2, t2);
+	pf_hl2.run();
+	EXPECT_EQ(pf_hl2.flowValue(), 5);
+
+	std::istringstream bad("p max 2 1\nn 1 s\nn 2 t\na 1 3 1\n");
+	Digraph g3;
+	ArcMap cap3(g3);
+	EXPECT_THROW(readDimacsMaxFlow(bad, g3, cap3, s, t), FormatError);
+
+	// capacities which do not fit the value type, or no integer at all
+	const char* too_large[3] = { "3000000000", "-2147483649", "99999999999999999999" };
+	for (int i = 0; i < 3; i++) {
+		std::istringstream big(std::string("p max 2 1\nn 1 s\nn 2 t\na 1 2 ") + too_large[i] + "\n");
+		Digraph g4;
+		ArcMap cap4(g4);
+		EXPECT_THROW(readDimacsMaxFlow(big, g4, cap4, s, t), FormatError);
+	}
+	std::istringstream wide("p max 2 1\nn 1 s\nn 2 t\na 1 2 3000000000\n");
+	Digraph g5;
+	Digraph::ArcMap<long long> cap5(g5);
+	readDimacsMaxFlow(wide, g5, cap5, s, t);
+	EXPECT_EQ(cap5[Digraph::ArcIt(g5)], 3000000000LL);
+}
+
+TEST(MappedDigraph, RoundTrip) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	writeBinaryDigraph("test.pfg", g, cap, s, t);
+	MappedDigraph mg("test.pfg");
+	MappedDigraph::CapacityMap<T> mcap(mg);
+	EXPECT_EQ(countNodes(mg), countNodes(g));
+	EXPECT_EQ(countArcs(mg), countArcs(g));
+	EXPECT_EQ(mg.id(mg.source()), g.id(s));
+	EXPECT_EQ(mg.id(mg.target()), g.id(t));
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		MappedDigraph::Node v = mg.nodeFromId(g.id(n));
+		EXPECT_EQ(countOutArcs(mg, v), countOutArcs(g, n));
+		EXPECT_EQ(countInArcs(mg, v), countInArcs(g, n));
+	}
+	Preflow_HL<Digraph, ArcMap> pf_hl(g, cap, s, t);
+	pf_hl.run();
+	Preflow_HL<MappedDigraph, MappedDigraph::CapacityMap<T> > pf_mapped(mg, mcap, mg.source(), mg.target());
+	pf_mapped.run();
+	EXPECT_EQ(pf_mapped.flowValue(), pf_hl.flowValue());
+	for (Digraph::NodeIt n(g); n != INVALID; ++n)
+		EXPECT_EQ(pf_mapped.minCut(mg.nodeFromId(g.id(n))), pf_hl.minCut(n));
+	EXPECT_THROW(MappedDigraph::CapacityMap<double> dcap(mg), FormatError);
+	// corrupt headers are rejected before the arrays are used
+	std::ifstream fin("test.pfg", std::ios::binary);
+	std::string bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+	const std::int64_t bad_values[4][4] = {
+		{ -1, countArcs(g), 0, 1 },
+		{ std::int64_t(1) << 32, countArcs(g), 0, 1 },
+		{ countNodes(g), -3, 0, 1 },
+		{ countNodes(g), countArcs(g), 0, countNodes(g) }
+	};
+	for (int i = 0; i < 4; i++) {
+		BinaryGraphHeader header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		header.node_num = bad_values[i][0];
+		header.arc_num = bad_values[i][1];
+		header.source = bad_values[i][2];
+		header.target = bad_values[i][3];
+		std::string corrupt = bytes;
+		std::memcpy(&corrupt[0], &header, sizeof(header));
+		std::ofstream("test_bad.pfg", std::ios::binary) << corrupt;
+		EXPECT_THROW(MappedDigraph bad("test_bad.pfg"), FormatError);
+	}
+	// and so are arrays with an index out of range or out of order
+	const std::size_t out_first = sizeof(BinaryGraphHeader);
+	const std::size_t arc_target = out_first + 4 * (countNodes(g) + 1);
+	const std::size_t in_arc = arc_target + 4 * (2 * countArcs(g) + countNodes(g) + 1);
+	const std::size_t bad_entries[4] = { out_first + 4, arc_target, arc_target + 4 * countArcs(g), in_arc };
+	for (int i = 0; i < 4; i++) {
+		std::string corrupt = bytes;
+		std::int32_t value = i == 0 ? countArcs(g) + 1 : -1;
+		std::memcpy(&corrupt[bad_entries[i]], &value, sizeof(value));
+		std::ofstream("test_bad.pfg", std::ios::binary) << corrupt;
+		EXPECT_THROW(MappedDigraph bad("test_bad.pfg"), FormatError);
+	}
+	std::remove("test_bad.pfg");
+}
+
+TEST(Preflow_Async, Official) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	digraphReader(g, "test.lgf")
+		.arcMap("capacity", cap)
+		.node("source", s)
+		.node("target", t)
+		.run();
+	Preflow<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	Preflow_Async<Digraph, ArcMap> pf_async(g, cap, s, t);
+	pf_async.run();
+	EXPECT_EQ(pf_async.flowValue(), pf.flowValue());
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		if (g.id(n) != 0 && g.id(n) != 7)
+			EXPECT_EQ(pf.minCut(n), pf_async.minCut(n));
+	}
+}
+
+TEST(Preflow_Async, Floating) {
+	typedef ListDigraph Digraph;
+	typedef double T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	Node n0 = g.addNode();
+	Node n1 = g.addNode();
+	Node n2 = g.addNode();
+	Node n3 = g.addNode();
+	ArcMap aM(g);
+	aM[g.addArc(n0, n1)] = 0.145;
+	aM[g.addArc(n0, n2)] = 0.21;
+	aM[g.addArc(n0, n3)] = 0.30;
+	aM[g.addArc(n1, n2)] = 0.003;
+	aM[g.addArc(n1, n3)] = 0.003;
+	aM[g.addArc(n2, n3)] = 0.82;
+	Preflow<Digraph, ArcMap> pf(g, aM, n0, n3);
+	pf.run();
+	Preflow_Async<Digraph, ArcMap> pf_async(g, aM, n0, n3);
+	pf_async.run();
+	EXPECT_NEAR(pf_async.flowValue(), pf.flowValue(), 1e-9);
+	for (Digraph::NodeIt n(g); n != INVALID; ++n) {
+		EXPECT_EQ(pf.minCut(n), pf_async.minCut(n));
+	}
+}
+
+TEST(Preflow_Parallel, RelabelAfterPush) {
+	// relabeling during the push pass used to miss arcs reversed by pushes
+	// of the same round and stopped with a non-maximum flow
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	const int arcs[][3] = {
+		{5, 5, 10}, {0, 3, 15}, {7, 9, 10}, {2, 13, 18}, {10, 3, 17}, {6, 0, 17}, {5, 8, 13},
+		{10, 10, 15}, {6, 4, 15}, {8, 6, 6}, {8, 11, 15}, {10, 0, 6}, {10, 10, 13}, {12, 5, 9},
+		{5, 9, 2}, {0, 10, 14}, {5, 5, 13}, {8, 1, 17}, {14, 13, 1}, {5, 5, 5}, {7, 12, 1},
+		{4, 11, 3}, {5, 2, 18}, {6, 9, 19}, {10, 8, 3}, {12, 14, 12}, {1, 12, 11}, {0, 0, 8},
+		{1, 13, 19}, {5, 8, 6}, {12, 14, 6}, {1, 1, 6}, {10, 3, 3}, {5, 4, 19}, {2, 7, 17},
+		{10, 11, 15}, {0, 1, 6}, {6, 14, 18}, {13, 9, 15}, {5, 3, 13}, {3, 1, 1}, {13, 2, 9},
+		{6, 1, 10}, {2, 13, 12}, {6, 3, 4}, {1, 6, 13}, {5, 2, 14}, {4, 9, 17}, {12, 10, 9},
+		{0, 7, 5}, {7, 8, 8}, {9, 14, 18}, {7, 2, 3}, {10, 4, 9}, {14, 9, 0}, {4, 11, 8},
+		{3, 14, 6}, {3, 0, 14}, {12, 1, 15}, {12, 9, 0}, {13, 7, 3}, {12, 10, 4}, {9, 5, 15},
+		{13, 13, 11}, {12, 1, 19} };
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Node> nodes;
+	for (int i = 0; i < 15; i++)
+		nodes.push_back(g.addNode());
+	for (const int* a : arcs)
+		cap[g.addArc(nodes[a[0]], nodes[a[1]])] = a[2];
+	Preflow<Digraph, ArcMap> pf(g, cap, nodes[0], nodes[2]);
+	pf.run();
+	for (double freq : { 0.0, 0.5, 100.0 }) {
+		Preflow_Parallel<Digraph, ArcMap> pf_para(g, cap, nodes[0], nodes[2]);
+		pf_para.globalRelabelFrequency(freq);
+		pf_para.run();
+		EXPECT_EQ(pf_para.flowValue(), pf.flowValue());
+		EXPECT_TRUE(pf_para.minCut(nodes[0]));
+		EXPECT_FALSE(pf_para.minCut(nodes[2]));
+	}
+}
+
+TEST(ParallelBfs, DenseCut) {
+	// the cut search turns bottom-up on a dense graph with a low diameter
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Node> nodes;
+	for (int i = 0; i < 200; i++)
+		nodes.push_back(g.addNode());
+	std::srand(7);
+	for (int i = 0; i < 200; i++) {
+		for (int j = 0; j < 200; j++) {
+			if (i != j && std::rand() % 4 == 0)
+				cap[g.addArc(nodes[i], nodes[j])] = std::rand() % 20;
+		}
+	}
+	Preflow<Digraph, ArcMap> pf(g, cap, nodes[0], nodes[1]);
+	pf.run();
+	Preflow_Parallel<Digraph, ArcMap> pf_para(g, cap, nodes[0], nodes[1]);
+	pf_para.run();
+	EXPECT_EQ(pf_para.flowValue(), pf.flowValue());
+	Preflow_Parallel<Digraph, ArcMap> pf_source(g, cap, nodes[0], nodes[1]);
+	pf_source.init();
+	pf_source.startFirstPhase();
+	pf_source.startSecondPhase(true);
+	EXPECT_EQ(pf_source.flowValue(), pf.flowValue());
+	for (Node n : nodes) {
+		EXPECT_EQ(pf.minCut(n), pf_para.minCut(n));
+		// the minimal source side lies within the maximal one
+		if (pf_source.minCutSource(n))
+			EXPECT_TRUE(pf_para.minCut(n));
+	}
+}
+
+// interior arcs change between solves, the warm started solver has to
+// agree with a solve from scratch after every batch
+template <typename PF>
+void expect_warm_starts(unsigned seed) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	typedef ListDigraph::Arc Arc;
+	std::srand(seed);
+	int node_num = 5 + std::rand() % 40;
+	int arc_num = node_num * (1 + std::rand() % 6);
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Node> nodes;
+	std::vector<Arc> arcs;
+	for (int i = 0; i < node_num; i++)
+		nodes.push_back(g.addNode());
+	for (int k = 0; k < arc_num; k++) {
+		int u = std::rand() % node_num, v = std::rand() % node_num;
+		if (u == v)
+			continue;
+		arcs.push_back(g.addArc(nodes[u], nodes[v]));
+		cap[arcs.back()] = std::rand() % 20;
+	}
+	PF pf(g, cap, nodes[0], nodes[1]);
+	pf.run();
+	for (int round = 0; round < 5 && !arcs.empty(); round++) {
+		std::vector<std::pair<Arc, T> > changes;
+		int change_num = 1 + std::rand() % 6;
+		for (int k = 0; k < change_num; k++) {
+			Arc a = arcs[std::rand() % arcs.size()];
+			cap[a] = std::rand() % 25;
+			changes.push_back(std::make_pair(a, cap[a]));
+		}
+		pf.updateCapacities(changes);
+		pf.startFirstPhase();
+		pf.startSecondPhase();
+		Preflow<Digraph, ArcMap> ref(g, cap, nodes[0], nodes[1]);
+		ref.run();
+		EXPECT_EQ(pf.flowValue(), ref.flowValue()) << "seed " << seed << " round " << round;
+		for (Node n : nodes)
+			EXPECT_EQ(ref.minCut(n), pf.minCut(n));
+	}
+}
+TEST(Preflow_Base, UpdateCapacities) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	for (unsigned seed = 0; seed < 100; seed++) {
+		expect_warm_starts<Preflow_HL<Digraph, ArcMap> >(seed);
+		expect_warm_starts<Preflow_Relabel<Digraph, ArcMap> >(seed);
+		expect_warm_starts<Preflow_FIFO<Digraph, ArcMap> >(seed);
+		expect_warm_starts<Preflow_Parallel<Digraph, ArcMap> >(seed);
+		expect_warm_starts<Preflow_Async<Digraph, ArcMap> >(seed);
+	}
+}
+
+// the active set Preflow_Parallel starts its next round with
+template <typename GR, typename CAP>
+class ParallelActiveSet : public Preflow_Parallel<GR, CAP> {
+public:
+	ParallelActiveSet(const GR& g, const CAP& cap, typename GR::Node s, typename GR::Node t)
+		: Preflow_Parallel<GR, CAP>(g, cap, s, t) {}
+	std::vector<int> nextActive() {
+		this->_elevator->concatenate_active_sets();
+		std::vector<int> ids;
+		for (int i = 0; i < this->_elevator->get_active_count(); i++)
+			ids.push_back(this->_graph->id(this->_elevator->get_node(i)));
+		return ids;
+	}
+};
+
+TEST(Preflow_Parallel, UpdateActivatesOnce) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	typedef ListDigraph::Node Node;
+	typedef ListDigraph::Arc Arc;
+	Digraph g;
+	ArcMap cap(g);
+	Node s = g.addNode(), a = g.addNode(), b = g.addNode(), c = g.addNode(), t = g.addNode();
+	cap[g.addArc(s, a)] = 10;
+	cap[g.addArc(a, b)] = 10;
+	Arc bc = g.addArc(b, c), bt = g.addArc(b, t);
+	cap[bc] = 5;
+	cap[bt] = 5;
+	cap[g.addArc(c, t)] = 5;
+	ParallelActiveSet<Digraph, ArcMap> pf(g, cap, s, t);
+	pf.run();
+	ASSERT_EQ(pf.flowValue(), 10);
+	// both arcs return flow to b
+	std::vector<std::pair<Arc, int> > changes;
+	changes.push_back(std::make_pair(bc, 1));
+	changes.push_back(std::make_pair(bt, 1));
+	pf.updateCapacities(changes);
+	std::vector<int> active = pf.nextActive();
+	EXPECT_EQ(std::count(active.begin(), active.end(), g.id(b)), 1);
+	std::sort(active.begin(), active.end());
+	EXPECT_TRUE(std::adjacent_find(active.begin(), active.end()) == active.end());
+}
+
+TEST(ParametricPreflow, Breakpoints) {
+	// min(lambda, 5) + min(1 + lambda, 8 - lambda) has breakpoints at 3.5 and 5
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<double> ArcMap;
+	typedef ListDigraph::Node Node;
+	typedef ListDigraph::Arc Arc;
+	Digraph g;
+	ArcMap cap(g), slope(g);
+	Node s = g.addNode(), t = g.addNode(), a = g.addNode(), b = g.addNode();
+	Arc e = g.addArc(s, a);
+	cap[e] = 0;
+	slope[e] = 1;
+	e = g.addArc(a, t);
+	cap[e] = 5;
+	slope[e] = 0;
+	e = g.addArc(s, b);
+	cap[e] = 1;
+	slope[e] = 1;
+	e = g.addArc(b, t);
+	cap[e] = 8;
+	slope[e] = -1;
+	e = g.addArc(a, b);
+	cap[e] = 0.5;
+	slope[e] = 0;
+	ParametricPreflow<Digraph, ArcMap> pp(g, cap, slope, s, t);
+	// the capacity of b->t stays nonnegative up to 8
+	pp.run(0, 8);
+	for (double lambda = 0; lambda <= 8; lambda += 0.25) {
+		ArcMap c(g);
+		for (Digraph::ArcIt arc(g); arc != INVALID; ++arc)
+			c[arc] = cap[arc] + lambda * slope[arc];
+		Preflow<Digraph, ArcMap> pf(g, c, s, t);
+		pf.run();
+		EXPECT_NEAR(pp.minCutValue(lambda), pf.flowValue(), 1e-9);
+	}
+	ASSERT_EQ(pp.breakpointNum(), 2);
+	EXPECT_NEAR(pp.breakpoint(0), 3.5, 1e-9);
+	EXPECT_NEAR(pp.breakpoint(1), 5, 1e-9);
+	// the source sides grow with lambda
+	EXPECT_FALSE(pp.minCut(a, 0));
+	EXPECT_FALSE(pp.minCut(b, 0));
+	EXPECT_FALSE(pp.minCut(a, 1));
+	EXPECT_TRUE(pp.minCut(b, 1));
+	EXPECT_TRUE(pp.minCut(a, 2));
+	EXPECT_TRUE(pp.minCut(b, 2));
+	EXPECT_FALSE(pp.minCut(t, 2));
+	// b->t becomes negative after 8, a->t may not have a slope
+	EXPECT_THROW(pp.run(0, 9), std::invalid_argument);
+	slope[g.addArc(a, t)] = 1;
+	EXPECT_THROW(pp.run(0, 8), std::invalid_argument);
+}
+
+TEST(ParametricPreflow, IntegralCapacities) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	typedef Digraph::ArcMap<double> DoubleMap;
+	typedef ListDigraph::Node Node;
+	std::srand(5);
+	for (int round = 0; round < 20; round++) {
+		Digraph g;
+		ArcMap cap(g), slope(g);
+		std::vector<Node> nodes;
+		int n = 5 + std::rand() % 30;
+		for (int i = 0; i < n; i++)
+			nodes.push_back(g.addNode());
+		Node s = nodes[0], t = nodes[1];
+		for (int i = 2; i < n; i++) {
+			ListDigraph::Arc e = g.addArc(s, nodes[i]);
+			cap[e] = std::rand() % 5;
+			slope[e] = std::rand() % 4;
+			e = g.addArc(nodes[i], t);
+			cap[e] = 20 + std::rand() % 20;
+			slope[e] = -(std::rand() % 3);
+		}
+		for (int k = 0; k < 4 * n; k++) {
+			int u = 2 + std::rand() % (n - 2), v = 2 + std::rand() % (n - 2);
+			if (u != v) {
+				ListDigraph::Arc e = g.addArc(nodes[u], nodes[v]);
+				cap[e] = std::rand() % 8;
+				slope[e] = 0;
+			}
+		}
+		ParametricPreflow<Digraph, ArcMap> pp(g, cap, slope, s, t);
+		pp.run(0, 10);
+		for (int k = 0; k <= 40; k++) {
+			double lambda = k * 0.25;
+			DoubleMap c(g);
+			for (Digraph::ArcIt arc(g); arc != INVALID; ++arc)
+				c[arc] = cap[arc] + lambda * slope[arc];
+			Preflow<Digraph, DoubleMap> pf(g, c, s, t);
+			pf.run();
+			EXPECT_NEAR(pp.minCutValue(lambda), pf.flowValue(), 1e-9);
+			// the source side of the interval of lambda is a minimum cut
+			int i = 0;
+			while (i < pp.breakpointNum() && pp.breakpoint(i) <= lambda)
+				i++;
+			double cut = 0;
+			for (Digraph::ArcIt arc(g); arc != INVALID; ++arc) {
+				if (pp.minCut(g.source(arc), i) && !pp.minCut(g.target(arc), i))
+					cut += c[arc];
+			}
+			EXPECT_NEAR(cut, pf.flowValue(), 1e-9);
+		}
+	}
+}
+
+TEST(BatchPreflow, Queries) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Node> nodes;
+	for (int i = 0; i < 25; i++)
+		nodes.push_back(g.addNode());
+	std::srand(3);
+	for (int k = 0; k < 120; k++) {
+		int u = std::rand() % 25, v = std::rand() % 25;
+		if (u != v)
+			cap[g.addArc(nodes[u], nodes[v])] = std::rand() % 20;
+	}
+	std::vector<std::pair<Node, Node> > queries;
+	for (int k = 0; k < 40; k++) {
+		int u = std::rand() % 25, v = std::rand() % 25;
+		if (u != v)
+			queries.push_back(std::make_pair(nodes[u], nodes[v]));
+	}
+	BatchPreflow<Digraph, ArcMap> batch(g, cap);
+	BatchPreflow<Digraph, ArcMap, Preflow_Parallel<Digraph, ArcMap> > batch_para(g, cap);
+	// the second run reuses the solvers of the first one
+	for (int r = 0; r < 2; r++) {
+		batch.run(queries, true);
+		batch_para.run(queries);
+		for (int q = 0; q < int(queries.size()); q++) {
+			Preflow<Digraph, ArcMap> pf(g, cap, queries[q].first, queries[q].second);
+			pf.run();
+			EXPECT_EQ(batch.flowValue(q), pf.flowValue());
+			EXPECT_EQ(batch_para.flowValue(q), pf.flowValue());
+			for (Node n : nodes)
+				EXPECT_EQ(batch.minCut(q, n), pf.minCut(n));
+		}
+	}
+}
+
+TEST(GomoryHuTree, AllPairs) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef ListDigraph::Node Node;
+	Digraph g, sym;
+	ArcMap cap(g), sym_cap(sym);
+	std::vector<Node> nodes, sym_nodes;
+	for (int i = 0; i < 15; i++) {
+		nodes.push_back(g.addNode());
+		sym_nodes.push_back(sym.addNode());
+	}
+	std::srand(11);
+	for (int k = 0; k < 40; k++) {
+		int u = std::rand() % 15, v = std::rand() % 15;
+		if (u == v)
+			continue;
+		T c = std::rand() % 10;
+		cap[g.addArc(nodes[u], nodes[v])] = c;
+		sym_cap[sym.addArc(sym_nodes[u], sym_nodes[v])] = c;
+		sym_cap[sym.addArc(sym_nodes[v], sym_nodes[u])] = c;
+	}
+	GomoryHuTree<Digraph, ArcMap> gh(g, cap);
+	// more sources at once than the tree allows, some are solved again
+	gh.batchSize(4);
+	gh.run();
+	EXPECT_GE(gh.flowNum(), 14);
+	for (int a = 0; a < 15; a++) {
+		for (int b = a + 1; b < 15; b++) {
+			Preflow<Digraph, ArcMap> pf(sym, sym_cap, sym_nodes[a], sym_nodes[b]);
+			pf.run();
+			EXPECT_EQ(gh.minCutValue(nodes[a], nodes[b]), pf.flowValue());
+			Digraph::NodeMap<bool> cut(g);
+			EXPECT_EQ(gh.minCutMap(nodes[a], nodes[b], cut), pf.flowValue());
+			EXPECT_TRUE(cut[nodes[a]]);
+			EXPECT_FALSE(cut[nodes[b]]);
+		}
+	}
+}
+TEST(Generators, Families) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	for (int family = 0; family < 5; family++) {
+		Digraph g;
+		ArcMap cap(g);
+		Digraph::Node s, t;
+		switch (family) {
+		case 0:
+			genrmf(g, cap, s, t, 3, 4, 1, 10, 5);
+			EXPECT_EQ(countNodes(g), 36);
+			EXPECT_EQ(countArcs(g), 4 * 24 + 3 * 9);
+			break;
+		case 1:
+			washingtonRLG(g, cap, s, t, 4, 5, 20, 5);
+			EXPECT_EQ(countNodes(g), 22);
+			EXPECT_EQ(countArcs(g), 8 + 4 * 4 * 3);
+			break;
+		case 2:
+			akNetwork(g, cap, s, t, 5);
+			EXPECT_EQ(countNodes(g), 4 * 5 + 6);
+			break;
+		case 3:
+			visionGrid(g, cap, s, t, 6, 5, 4, 10, 5);
+			break;
+		default:
+			visionGrid(g, cap, s, t, 6, 5, 8, 10, 5);
+			break;
+		}
+		Preflow<Digraph, ArcMap> ref(g, cap, s, t);
+		ref.run();
+		Preflow_Relabel<Digraph, ArcMap> rtf(g, cap, s, t);
+		rtf.run();
+		EXPECT_EQ(rtf.flowValue(), ref.flowValue());
+		Preflow_FIFO<Digraph, ArcMap> fifo(g, cap, s, t);
+		fifo.run();
+		EXPECT_EQ(fifo.flowValue(), ref.flowValue());
+		Preflow_HL<Digraph, ArcMap> hl(g, cap, s, t);
+		hl.run();
+		EXPECT_EQ(hl.flowValue(), ref.flowValue());
+		Preflow_Parallel<Digraph, ArcMap> pg(g, cap, s, t);
+		pg.run();
+		EXPECT_EQ(pg.flowValue(), ref.flowValue());
+	}
+	// equal seeds give equal graphs
+	Digraph g1, g2;
+	Digraph::ArcMap<double> c1(g1), c2(g2);
+	Digraph::Node s1, t1, s2, t2;
+	rbfGraph(g1, c1, s1, t1, 30, 0.6, 9);
+	rbfGraph(g2, c2, s2, t2, 30, 0.6, 9);
+	EXPECT_EQ(countArcs(g1), countArcs(g2));
+	Preflow<Digraph, Digraph::ArcMap<double> > p1(g1, c1, s1, t1), p2(g2, c2, s2, t2);
+	p1.run();
+	p2.run();
+	EXPECT_DOUBLE_EQ(p1.flowValue(), p2.flowValue());
+	EXPECT_GT(p1.flowValue(), 0);
+}
+TEST(PreflowStatistics, Counters) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef Digraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	genrmf(g, cap, s, t, 3, 4, 1, 10, 5);
+	Preflow_HL<Digraph, ArcMap, PreflowStatisticsTraits<Preflow_HLDefaultTraits<Digraph, ArcMap> > > hl(g, cap, s, t);
+	hl.globalRelabelFrequency(0.5);
+	hl.run();
+	PreflowCounters c = hl.statistics();
+	EXPECT_GT(c.saturating_pushes, 0);
+	EXPECT_GT(c.discharges, 0);
+	EXPECT_GT(c.relabels, 0);
+	EXPECT_LE(c.push_backs, c.saturating_pushes + c.nonsaturating_pushes);
+	EXPECT_EQ(c.rounds, 0);
+	// the default traits count nothing
+	Preflow_HL<Digraph, ArcMap> plain(g, cap, s, t);
+	plain.run();
+	EXPECT_EQ(plain.flowValue(), hl.flowValue());
+	EXPECT_EQ(plain.statistics().discharges, 0);
+	Preflow_Parallel<Digraph, ArcMap, PreflowStatisticsTraits<Preflow_ParallelDefaultTraits<Digraph, ArcMap> > > pg(g, cap, s, t);
+	pg.run();
+	EXPECT_EQ(pg.flowValue(), hl.flowValue());
+	c = pg.statistics();
+	EXPECT_GT(c.rounds, 0);
+	EXPECT_EQ(int(c.active_per_round.size()), c.rounds);
+	EXPECT_GT(c.saturating_pushes + c.nonsaturating_pushes, 0);
+}
+TEST(Preflow_Base, Cancellation) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef Digraph::Node Node;
+	Digraph g;
+	ArcMap cap(g);
+	Node s, t;
+	genrmf(g, cap, s, t, 4, 6, 1, 20, 3);
+	Preflow<Digraph, ArcMap> ref(g, cap, s, t);
+	ref.run();
+	std::atomic<bool> stop(true);
+	Preflow_HL<Digraph, ArcMap> hl(g, cap, s, t);
+	EXPECT_EQ(hl.run(stop), hl.INTERRUPTED);
+	EXPECT_LE(hl.flowValue(), ref.flowValue());
+	// the preflow is intact, the phases resume from it
+	stop = false;
+	hl.stopToken(&stop);
+	hl.startFirstPhase();
+	EXPECT_EQ(hl.status(), hl.COMPLETED);
+	hl.startSecondPhase();
+	EXPECT_EQ(hl.flowValue(), ref.flowValue());
+	// a passed deadline stops at the first check, a later one does not
+	Preflow_FIFO<Digraph, ArcMap> fifo(g, cap, s, t);
+	fifo.checkInterval(1);
+	EXPECT_EQ(fifo.run(std::chrono::steady_clock::now()), fifo.INTERRUPTED);
+	EXPECT_EQ(fifo.run(std::chrono::steady_clock::now() + std::chrono::hours(1)), fifo.COMPLETED);
+	EXPECT_EQ(fifo.flowValue(), ref.flowValue());
+	Preflow_Relabel<Digraph, ArcMap> rtf(g, cap, s, t);
+	stop = true;
+	EXPECT_EQ(rtf.run(stop), rtf.INTERRUPTED);
+	Preflow_Parallel<Digraph, ArcMap> pg(g, cap, s, t);
+	EXPECT_EQ(pg.run(stop), pg.INTERRUPTED);
+	stop = false;
+	pg.startFirstPhase();
+	EXPECT_EQ(pg.status(), pg.COMPLETED);
+	EXPECT_EQ(pg.flowValue(), ref.flowValue());
+	Preflow_Async<Digraph, ArcMap> async(g, cap, s, t);
+	stop = true;
+	EXPECT_EQ(async.run(stop), async.INTERRUPTED);
+	EXPECT_LE(async.flowValue(), ref.flowValue());
+}
+template <typename PF, typename Digraph, typename ArcMap>
+void expect_valid_flow(const Digraph& g, const ArcMap& cap, typename Digraph::Node s, typename Digraph::Node t) {
+	PF pf(g, cap, s, t);
+	pf.run();
+	const typename PF::FlowMap& flow = pf.flowMap();
+	for (typename Digraph::NodeIt n(g); n != INVALID; ++n) {
+		if (n == s || n == t)
+			continue;
+		typename PF::Value excess = 0;
+		for (typename Digraph::InArcIt e(g, n); e != INVALID; ++e)
+			excess += flow[e];
+		for (typename Digraph::OutArcIt e(g, n); e != INVALID; ++e)
+			excess -= flow[e];
+		EXPECT_EQ(excess, 0);
+	}
+	for (typename Digraph::ArcIt e(g); e != INVALID; ++e) {
+		EXPECT_GE(flow[e], 0);
+		EXPECT_LE(flow[e], cap[e]);
+	}
+}
+TEST(Preflow_Base, SecondPhaseFlow) {
+	typedef ListDigraph Digraph;
+	typedef int T;
+	typedef Digraph::ArcMap<T> ArcMap;
+	typedef Digraph::Node Node;
+	// dense random digraphs have flow cycles behind the cut
+	for (int seed = 0; seed < 20; seed++) {
+		Digraph g;
+		ArcMap cap(g);
+		std::vector<Node> nodes;
+		for (int i = 0; i < 20; i++)
+			nodes.push_back(g.addNode());
+		std::srand(seed);
+		for (int k = 0; k < 100; k++) {
+			int u = std::rand() % 20, v = std::rand() % 20;
+			if (u != v)
+				cap[g.addArc(nodes[u], nodes[v])] = std::rand() % 20;
+		}
+		expect_valid_flow<Preflow_Relabel<Digraph, ArcMap> >(g, cap, nodes[0], nodes[19]);
+		expect_valid_flow<Preflow_FIFO<Digraph, ArcMap> >(g, cap, nodes[0], nodes[19]);
+		expect_valid_flow<Preflow_HL<Digraph, ArcMap> >(g, cap, nodes[0], nodes[19]);
+		expect_valid_flow<Preflow_Async<Digraph, ArcMap> >(g, cap, nodes[0], nodes[19]);
+	}
+}
+template <typename V>
+double integral_flow(int rule) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<V> ArcMap;
+	Digraph g;
+	ArcMap cap(g);
+	Digraph::Node s, t;
+	washingtonRLG(g, cap, s, t, 8, 10, 1000, 4);
+	switch (rule) {
+	case 0: { Preflow_Relabel<Digraph, ArcMap> pf(g, cap, s, t); pf.run(); return double(pf.flowValue()); }
+	case 1: { Preflow_FIFO<Digraph, ArcMap> pf(g, cap, s, t); pf.run(); return double(pf.flowValue()); }
+	case 2: { Preflow_HL<Digraph, ArcMap> pf(g, cap, s, t); pf.run(); return double(pf.flowValue()); }
+	case 3: { Preflow_Parallel<Digraph, ArcMap> pf(g, cap, s, t); pf.run(); return double(pf.flowValue()); }
+	default: { Preflow_Async<Digraph, ArcMap> pf(g, cap, s, t); pf.run(); return double(pf.flowValue()); }
+	}
+}
+TEST(Preflow_Base, IntegralKernels) {
+	for (int rule = 0; rule < 5; rule++) {
+		double value = integral_flow<double>(rule);
+		EXPECT_EQ(integral_flow<int>(rule), value);
+		EXPECT_EQ(integral_flow<long long>(rule), value);
+	}
+}
+TEST(Preflow_Base, NodeStateLayouts) {
+	// the split (SoA) layout gives the same flows as the packed (AoS) default
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	typedef SplitNodeState<int> Split;
+	Digraph g;
+	ArcMap cap(g);
+	Digraph::Node s, t;
+	genrmf(g, cap, s, t, 4, 5, 1, 100, 7);
+	Preflow_HL<Digraph, ArcMap> reference(g, cap, s, t);
+	reference.run();
+	int value = reference.flowValue();
+	Preflow_Relabel<Digraph, ArcMap, Preflow_RelabelDefaultTraits<Digraph, ArcMap, Split> > rtf(g, cap, s, t);
+	rtf.run();
+	EXPECT_EQ(rtf.flowValue(), value);
+	Preflow_FIFO<Digraph, ArcMap, Preflow_FIFODefaultTraits<Digraph, ArcMap, Split> > fifo(g, cap, s, t);
+	fifo.run();
+	EXPECT_EQ(fifo.flowValue(), value);
+	Preflow_HL<Digraph, ArcMap, Preflow_HLDefaultTraits<Digraph, ArcMap, Split> > hl(g, cap, s, t);
+	hl.run();
+	EXPECT_EQ(hl.flowValue(), value);
+	Preflow_Parallel<Digraph, ArcMap, Preflow_ParallelDefaultTraits<Digraph, ArcMap, Split> > pg(g, cap, s, t);
+	pg.run();
+	EXPECT_EQ(pg.flowValue(), value);
+	Preflow_Async<Digraph, ArcMap,
+		Preflow_AsyncDefaultTraits<Digraph, ArcMap, SplitNodeState<int, std::atomic<int> > > > async(g, cap, s, t);
+	async.run();
+	EXPECT_EQ(async.flowValue(), value);
+	// a copied elevator carries the node state, the excess included, along
+	Preflow_HL<Digraph, ArcMap, Preflow_HLDefaultTraits<Digraph, ArcMap, Split> >::Elevator* ele = hl.elevator();
+	EXPECT_EQ(ele->nodeState().excess(g.id(t)), value);
+	for (Digraph::NodeIt n(g); n != INVALID; ++n)
+		EXPECT_EQ((*ele)[n], ele->nodeState().level(g.id(n)));
+	delete ele;
+}
+// total id distance of the ends of the arcs
+long idDistance(const ListDigraph& g) {
+	long distance = 0;
+	for (ListDigraph::ArcIt e(g); e != INVALID; ++e)
+		distance += std::abs(g.id(g.source(e)) - g.id(g.target(e)));
+	return distance;
+}
+TEST(ReorderedDigraph, Orders) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	Digraph grid;
+	ArcMap grid_cap(grid);
+	Digraph::Node gs, gt;
+	washingtonRLG(grid, grid_cap, gs, gt, 12, 15, 1000, 3);
+	// the same grid with the node ids in random order, as read from a file
+	std::vector<int> perm(grid.maxNodeId() + 1);
+	for (int i = 0; i < int(perm.size()); i++)
+		perm[i] = i;
+	std::mt19937 rng(5);
+	std::shuffle(perm.begin(), perm.end(), rng);
+	Digraph g;
+	ArcMap cap(g);
+	std::vector<Digraph::Node> nodes(perm.size());
+	for (int i = 0; i < int(perm.size()); i++)
+		nodes[i] = g.addNode();
+	for (Digraph::ArcIt e(grid); e != INVALID; ++e)
+		cap.set(g.addArc(nodes[perm[grid.id(grid.source(e))]], nodes[perm[grid.id(grid.target(e))]]), grid_cap[e]);
+	Digraph::Node s = nodes[perm[grid.id(gs)]], t = nodes[perm[grid.id(gt)]];
+	Preflow<Digraph, ArcMap> ref(g, cap, s, t);
+	ref.run();
+
+	NodeOrder orders[4] = { ORDER_NONE, ORDER_BFS, ORDER_RCM, ORDER_DEGREE };
+	for (NodeOrder order : orders) {
+		ReorderedDigraph<Digraph, ArcMap> re(g, cap, s, t, order);
+		EXPECT_EQ(countNodes(re.graph()), countNodes(g));
+		EXPECT_EQ(countArcs(re.graph()), countArcs(g));
+		for (Digraph::NodeIt n(g); n != INVALID; ++n)
+			EXPECT_EQ(re.originalNode(re.node(n)), n);
+		if (order == ORDER_BFS)
+			EXPECT_EQ(re.graph().id(re.target()), 0);
+		if (order == ORDER_RCM || order == ORDER_BFS)
+			EXPECT_LT(idDistance(re.graph()), idDistance(g) / 4);
+		Preflow_HL<Digraph, ArcMap> pf(re.graph(), re.capacityMap(), re.source(), re.target());
+		pf.run();
+		EXPECT_EQ(pf.flowValue(), ref.flowValue());
+		// the cut and the flow on the original graph
+		Digraph::NodeMap<bool> cut(g);
+		ArcMap flow(g);
+		re.minCutMap(pf, cut);
+		re.flowMap(pf, flow);
+		EXPECT_TRUE(cut[s]);
+		EXPECT_FALSE(cut[t]);
+		int cut_value = 0;
+		Digraph::NodeMap<int> excess(g, 0);
+		for (Digraph::ArcIt e(g); e != INVALID; ++e) {
+			if (cut[g.source(e)] && !cut[g.target(e)])
+				cut_value += cap[e];
+			EXPECT_GE(flow[e], 0);
+			EXPECT_LE(flow[e], cap[e]);
+			excess[g.source(e)] -= flow[e];
+			excess[g.target(e)] += flow[e];
+		}
+		EXPECT_EQ(cut_value, ref.flowValue());
+		for (Digraph::NodeIt n(g); n != INVALID; ++n)
+			if (n != s && n != t)
+				EXPECT_EQ(excess[n], 0);
+		EXPECT_EQ(excess[t], ref.flowValue());
+	}
+	EXPECT_THROW(nodeOrder("random"), FormatError);
+}
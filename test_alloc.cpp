@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <lemon/list_graph.h>
+#include <lemon/preflow.h>
+#include "mf_base.h"
+#include "graph_generators.h"
+using namespace lemon;
+// heap allocations of the whole program. The global operators are replaced
+// for this executable only, the other tests run with the default ones.
+static std::atomic<long long> allocation_count(0);
+void* operator new(std::size_t size) {
+	allocation_count++;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+// gcc pairs the free() below with the new expressions it inlines the
+// deletes into and reports a mismatch, but operator new above is malloc()
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+template <typename PF>
+void expect_reset_without_allocation() {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	Digraph g1, g2;
+	ArcMap c1(g1), c2(g2);
+	Digraph::Node s1, t1, s2, t2;
+	washingtonRLG(g1, c1, s1, t1, 8, 10, 1000, 4);
+	genrmf(g2, c2, s2, t2, 4, 5, 1, 100, 7);
+	Preflow<Digraph, ArcMap> ref1(g1, c1, s1, t1), ref2(g2, c2, s2, t2);
+	ref1.run();
+	ref2.run();
+	// the first solves of both instances size the buffers
+	PF pf(g1, c1, s1, t1);
+	pf.run();
+	pf.reset(g2, c2, s2, t2);
+	pf.run();
+	int values[4];
+	long long before = allocation_count;
+	for (int k = 0; k < 4; k += 2) {
+		pf.reset(g1, c1, s1, t1);
+		pf.run();
+		values[k] = pf.flowValue();
+		pf.reset(g2, c2, s2, t2);
+		pf.run();
+		values[k + 1] = pf.flowValue();
+	}
+	EXPECT_EQ(allocation_count - before, 0);
+	for (int k = 0; k < 4; k += 2) {
+		EXPECT_EQ(values[k], ref1.flowValue());
+		EXPECT_EQ(values[k + 1], ref2.flowValue());
+	}
+	// the flow map follows the new digraph
+	int out = 0;
+	for (Digraph::OutArcIt e(g2, s2); e != INVALID; ++e)
+		out += pf.flowMap()[e];
+	for (Digraph::InArcIt e(g2, s2); e != INVALID; ++e)
+		out -= pf.flowMap()[e];
+	EXPECT_EQ(out, ref2.flowValue());
+}
+TEST(Preflow_Base, ResetReusesMemory) {
+	typedef ListDigraph Digraph;
+	typedef Digraph::ArcMap<int> ArcMap;
+	expect_reset_without_allocation<Preflow_Relabel<Digraph, ArcMap> >();
+	expect_reset_without_allocation<Preflow_FIFO<Digraph, ArcMap> >();
+	expect_reset_without_allocation<Preflow_HL<Digraph, ArcMap> >();
+	expect_reset_without_allocation<Preflow_Parallel<Digraph, ArcMap> >();
+	expect_reset_without_allocation<Preflow_Async<Digraph, ArcMap> >();
+}